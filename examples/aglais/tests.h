@@ -20,9 +20,52 @@
 
 #include "Kaleidoscope-Simulator.h"
 #include "kaleidoscope_simulator/AglaisInterface.h"
+#include "kaleidoscope_simulator/AglaisParallelReplay.h"
+#include "kaleidoscope_simulator/AglaisDivergence.h"
+#include "kaleidoscope_simulator/AglaisCycleStatistics.h"
 
 #include <iostream>
 #include <sstream>
+#include <string.h>
+
+// An Aglais recording may be passed as command line argument. If none
+// is given, the recording compiled into the binary is replayed.
+// Long recordings can be replayed in parallel segments by 
+// passing --parallel. With --divergence, the replay
+// stops at the first cycle whose reports differ from the recording.
+// --statistics reports the recorded cycle durations. It can not be 
+// combined with --parallel or --divergence. Options and the path may 
+// be given in any order.
+//
+const char *recording_path = nullptr;
+bool replay_parallel = false;
+bool find_divergence = false;
+bool cycle_statistics = false;
+
+void parseCommandLine(int argc, char* argv[]) { 
+   for(int i = 1; i < argc; ++i) {
+      if(strncmp(argv[i], "--", 2) != 0) {
+         if(recording_path) {
+            std::cerr << "Ignoring surplus argument " << argv[i] << std::endl;
+         }
+         else {
+            recording_path = argv[i];
+         }
+      }
+      else if(strcmp(argv[i], "--parallel") == 0) {
+         replay_parallel = true;
+      }
+      else if(strcmp(argv[i], "--divergence") == 0) {
+         find_divergence = true;
+      }
+      else if(strcmp(argv[i], "--statistics") == 0) {
+         cycle_statistics = true;
+      }
+      else {
+         std::cerr << "Ignoring unknown option " << argv[i] << std::endl;
+      }
+   }
+}
    
 KALEIDOSCOPE_SIMULATOR_INIT
 
@@ -38,13 +81,48 @@ void runSimulator(Simulator &simulator) {
    //simulator.setQuiet();
    
    auto test = simulator.newTest("Aglais test");
+   
+   // Parallel replays and divergence searches do not aggregate
+   // cycle statistics.
+   //
+   if(cycle_statistics && (replay_parallel || find_divergence)) {
+      simulator.error() << "--statistics can not be combined with "
+                           "--parallel or --divergence";
+      return;
+   }
       
 //    simulator.permanentBootKeyboardReportActions().add(GenerateHostEvent<BootKeyboardReport>{});
 //    simulator.permanentKeyboardReportActions().add(GenerateHostEvent<KeyboardReport>{});
 //    simulator.permanentMouseReportActions().add(GenerateHostEvent<MouseReport>{});
 //    simulator.permanentAbsoluteMouseReportActions().add(GenerateHostEvent<AbsoluteMouseReport>{});
 
-   processAglaisDocument(aglais_test_recording, simulator);
+   AglaisCycleStatistics statistics;
+   if(cycle_statistics) {
+      setAglaisCycleStatistics(&statistics);
+   }
+   
+   if(recording_path && find_divergence) {
+      auto divergence = findAglaisDivergenceInFile(recording_path, simulator);
+      if(divergence.found) {
+         simulator.error() << "First divergence in cycle " << divergence.cycle_id
+            << " (time " << divergence.time << ")\n"
+            << divergence.input_events << divergence.report_diff;
+      }
+   }
+   else if(recording_path && replay_parallel) {
+      processAglaisFileParallel(recording_path, simulator);
+   }
+   else if(recording_path) {
+      processAglaisFile(recording_path, simulator);
+   }
+   else {
+      processAglaisDocument(aglais_test_recording, simulator);
+   }
+   
+   if(cycle_statistics) {
+      setAglaisCycleStatistics(nullptr);
+      statistics.logResults(simulator);
+   }
 }
 
 const char aglais_test_recording[] =
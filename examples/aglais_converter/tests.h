@@ -0,0 +1,104 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard 
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef KALEIDOSCOPE_VIRTUAL_BUILD
+
+#include "Kaleidoscope-Simulator.h"
+#include "kaleidoscope_simulator/AglaisInterface.h"
+
+#include <string.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+// Usage: <binary> <input file> <output file>
+//
+// Converts an Aglais document. Output files with extension .aglb 
+// are written in binary format, all others in text format.
+//
+// Without arguments, the recording of the aglais example is converted 
+// to binary and back and the binary document is replayed.
+//
+const char *input_path = nullptr;
+const char *output_path = nullptr;
+
+void parseCommandLine(int argc, char* argv[]) { 
+   if(argc > 2) {
+      input_path = argv[argc - 2];
+      output_path = argv[argc - 1];
+   }
+}
+   
+KALEIDOSCOPE_SIMULATOR_INIT
+
+namespace kaleidoscope {
+namespace simulator {
+   
+extern const char aglais_test_recording[];
+   
+void runSimulator(Simulator &simulator) {
+   
+   if(input_path) {
+      
+      size_t path_length = strlen(output_path);
+      bool binary = (path_length > 5) 
+         && (strcmp(output_path + path_length - 5, ".aglb") == 0);
+      
+      std::ifstream in(input_path, std::ios::binary);
+      std::ofstream out(output_path, std::ios::binary);
+      
+      if(!in || !out) {
+         simulator.error() << "Unable to open input or output file";
+         return;
+      }
+      
+      convertAglaisDocument(in, out, 
+         (binary) ? AglaisFormat::binary : AglaisFormat::text);
+      return;
+   }
+   
+   std::istringstream text_in{aglais_test_recording};
+   std::ostringstream binary_out;
+   convertAglaisDocument(text_in, binary_out, AglaisFormat::binary);
+   
+   std::string binary_document = binary_out.str();
+   
+   std::istringstream binary_in{binary_document};
+   std::ostringstream text_out;
+   convertAglaisDocument(binary_in, text_out, AglaisFormat::text);
+   
+   simulator.log() << "Text document: " << strlen(aglais_test_recording) << " bytes";
+   simulator.log() << "Binary document: " << binary_document.size() << " bytes";
+   
+   if(text_out.str() != aglais_test_recording) {
+      simulator.error() << "Text document changed during conversion";
+   }
+   
+   auto test = simulator.newTest("Binary Aglais replay");
+   
+   processAglaisDocument(binary_document.data(), binary_document.size(), simulator);
+}
+
+const char aglais_test_recording[] =
+#include "../aglais/IO_protocoll.agl"
+;
+
+} // namespace simulator
+} // namespace kaleidoscope
+
+#endif
@@ -0,0 +1,77 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard 
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef KALEIDOSCOPE_VIRTUAL_BUILD
+
+#include "Kaleidoscope-Simulator.h"
+#include "kaleidoscope_simulator/AglaisCorpus.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Usage: <binary> [-j <workers>] <directory>...
+//
+// Replays all Aglais recordings (*.agl, *.aglb) of the given 
+// directories in parallel and reports pass/fail results and throughput.
+//
+std::vector<const char*> corpus_directories;
+unsigned max_workers = 0;
+
+void parseCommandLine(int argc, char* argv[]) { 
+   for(int i = 1; i < argc; ++i) {
+      if((strcmp(argv[i], "-j") == 0) && (i + 1 < argc)) {
+         max_workers = unsigned(atoi(argv[++i]));
+      }
+      else {
+         corpus_directories.push_back(argv[i]);
+      }
+   }
+}
+   
+KALEIDOSCOPE_SIMULATOR_INIT
+
+namespace kaleidoscope {
+namespace simulator {
+   
+void runSimulator(Simulator &simulator) {
+   
+   auto test = simulator.newTest("Aglais corpus");
+   
+   AglaisCorpusOptions options;
+   options.max_workers = max_workers;
+   
+   AglaisCorpusRunner runner{simulator, options};
+   
+   if(corpus_directories.empty()) {
+      simulator.error() << "No corpus directory given";
+      return;
+   }
+   
+   for(auto directory: corpus_directories) {
+      runner.addDirectory(directory);
+   }
+   
+   runner.run();
+   runner.logResults();
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
+
+#endif
@@ -0,0 +1,94 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard 
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef KALEIDOSCOPE_VIRTUAL_BUILD
+
+#include "Kaleidoscope-Simulator.h"
+#include "kaleidoscope_simulator/AglaisInterface.h"
+#include "kaleidoscope_simulator/AglaisRecorder.h"
+
+#include <fstream>
+#include <sstream>
+
+// Usage: <binary> [<output file>]
+//
+// Records a scripted session as Aglais document and replays the
+// recording from the initial firmware state. If an output file 
+// is given, the recording is also written to it.
+//
+const char *output_path = nullptr;
+
+void parseCommandLine(int argc, char* argv[]) { 
+   if(argc > 1) {
+      output_path = argv[argc - 1];
+   }
+}
+   
+KALEIDOSCOPE_SIMULATOR_INIT
+
+namespace kaleidoscope {
+namespace simulator {
+   
+void runSimulator(Simulator &simulator) {
+   
+   FirmwareSnapshot initial_state;
+   simulator.takeSnapshot(initial_state);
+   
+   std::ostringstream document;
+   
+   {
+      auto test = simulator.newTest("Aglais recording");
+      
+      AglaisRecorder recorder{document};
+      simulator.setAglaisRecorder(&recorder);
+      
+      simulator.cycles(10);
+      
+      simulator.pressKey(2, 1); // A
+      simulator.cycle();
+      simulator.pressKey(3, 5); // B
+      simulator.cycles(3);
+      simulator.releaseKey(2, 1);
+      simulator.releaseKey(3, 5);
+      simulator.cycles(100);
+      
+      simulator.tapKey(2, 1);
+      simulator.cycles(100);
+      
+      simulator.setAglaisRecorder(nullptr);
+      
+      simulator.log() << "Recorded " << recorder.getNumCycles() << " cycles";
+   }
+   
+   if(output_path) {
+      std::ofstream out(output_path, std::ios::binary);
+      out << document.str();
+   }
+   
+   auto test = simulator.newTest("Aglais replay of the recording");
+   
+   simulator.restoreSnapshot(initial_state);
+   
+   std::string recording = document.str();
+   processAglaisDocument(recording.data(), recording.size(), simulator);
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
+
+#endif
@@ -41,6 +41,16 @@ void runSimulator(Simulator &simulator) {
    
    //simulator.permanentKeyboardReportActions().add(DumpReport{});
    
+   // Store the initial firmware state to be able to return to it later on.
+   //
+   FirmwareSnapshot initial_state;
+   simulator.takeSnapshot(initial_state);
+   
+   // Parts of the initial state that the tests below change.
+   //
+   const auto initial_color = Kaleidoscope.device().getCrgbAt(KeyAddr{0, 0});
+   const auto initial_top_layer = Layer.top();
+   
    //***************************************************************************
    {
       auto test = simulator.newTest("0");
@@ -360,6 +370,105 @@ void runSimulator(Simulator &simulator) {
 
       assertKeyLEDState(simulator, key_led_colors);
    }
+   
+   //***************************************************************************
+   {
+      auto test = simulator.newTest("17");
+      
+      // Return to the initial firmware state. This resets layers, 
+      // LED effects and keystates without replaying any cycles.
+      // A layer is activated to make sure that the restore changes 
+      // the layer stack as well.
+      //
+      Layer.activate(1);
+      
+      simulator.restoreSnapshot(initial_state);
+      
+      const auto color = Kaleidoscope.device().getCrgbAt(KeyAddr{0, 0});
+      
+      PAPILIO_ASSERT_CONDITION(simulator, 
+                               (color.r == initial_color.r)
+                               && (color.g == initial_color.g)
+                               && (color.b == initial_color.b));
+      PAPILIO_ASSERT_CONDITION(simulator, Layer.top() == initial_top_layer);
+      
+      simulator.tapKey(2, 1); // A
+      simulator.cycleExpectReports(AssertKeycodesActive{Key_A});
+      
+      PAPILIO_ASSERT_CONDITION(simulator, 
+                               Kaleidoscope.device().getCrgbAt(KeyAddr{0, 0}).r != solid_red_level);
+   }
+   
+   //***************************************************************************
+   {
+      auto test = simulator.newTest("18");
+      
+      // Schedule key actions and jump straight from one to the next
+      // instead of running all cycles in between.
+      //
+      auto start_time = simulator.getSimulatorCore().getTime();
+      
+      simulator.scheduleAt(start_time + 500, [&]() { simulator.pressKey(2, 1); }); // A
+      simulator.scheduleAt(start_time + 1000, [&]() { simulator.releaseKey(2, 1); });
+      
+      // The press and the release each generate a report.
+      //
+      simulator.reportActionsQueue().queue(AssertKeycodesActive{Key_A});
+      simulator.reportActionsQueue().queue(AssertReportEmpty{});
+      
+      simulator.runUntil(start_time + 500);
+      
+      PAPILIO_ASSERT_CONDITION(simulator, 
+                               simulator.getSimulatorCore().getTime() == start_time + 500);
+      PAPILIO_ASSERT_CONDITION(simulator, simulator.getPressedKeys().test(2, 1));
+      
+      simulator.runUntil(start_time + 1000);
+      
+      PAPILIO_ASSERT_CONDITION(simulator, 
+                               simulator.getSimulatorCore().getTime() == start_time + 1000);
+      PAPILIO_ASSERT_CONDITION(simulator, !simulator.getPressedKeys().any());
+      
+      simulator.runUntil(start_time + 1500);
+      
+      PAPILIO_ASSERT_CONDITION(simulator, 
+                               simulator.getSimulatorCore().getTime() == start_time + 1500);
+   }
+   
+   //***************************************************************************
+   {
+      auto test = simulator.newTest("19");
+      
+      // Check what changed with each report and look back at 
+      // the reports emitted before.
+      //
+      auto &history = simulator.getReportHistory();
+      history.clear();
+      
+      simulator.pressKey(2, 1); // A
+      simulator.cycleExpectReports(AssertKeycodesPressed{Key_A});
+      
+      simulator.pressKey(3, 7); // left shift
+      simulator.cycleExpectReports(AssertKeycodesPressed{Key_LeftShift});
+      
+      simulator.releaseKey(2, 1); // A
+      simulator.releaseKey(3, 7); // left shift
+      simulator.cycleExpectReports(AssertKeycodesReleased{Key_A, Key_LeftShift});
+      
+      auto now = simulator.getSimulatorCore().getTime();
+      auto recent_reports = history.getSince(HIDReportType::keyboard, now - 50);
+      
+      PAPILIO_ASSERT_CONDITION(simulator, recent_reports.size() >= 3);
+      
+      auto n_reports_with_a = history.count(HIDReportType::keyboard,
+         [](const ReportHistory::Entry &entry) {
+            return entry.report.get<KeyboardReport>().isKeycodeActive(HID_KEYBOARD_A_AND_A);
+         }
+      );
+      
+      PAPILIO_ASSERT_CONDITION(simulator, n_reports_with_a >= 2);
+      
+      simulator.cycles(5);
+   }
 }
 
 } // namespace simulator
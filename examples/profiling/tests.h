@@ -0,0 +1,96 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard 
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef KALEIDOSCOPE_VIRTUAL_BUILD
+
+#include "Kaleidoscope-Simulator.h"
+#include "kaleidoscope_simulator/vendors/keyboardio/model01.h"
+
+// The sketch registers the MouseKeys plugin through a ProfiledPlugin 
+// proxy, see KALEIDOSCOPE_SIMULATOR_PROFILED_PLUGIN(MouseKeys) in sketch.ino.
+// The proxy is only used if KALEIDOSCOPE_SIMULATOR_PROFILE_MOUSE_KEYS 
+// is defined, which the examples' Makefile does for this example only.
+
+#ifndef KALEIDOSCOPE_SIMULATOR_PROFILE_MOUSE_KEYS
+#error "The profiling example requires KALEIDOSCOPE_SIMULATOR_PROFILE_MOUSE_KEYS"
+#endif
+   
+KALEIDOSCOPE_SIMULATOR_INIT
+
+namespace kaleidoscope {
+namespace simulator {
+   
+void runSimulator(Simulator &simulator) {
+   
+   using namespace kaleidoscope::simulator::actions;
+   using namespace papilio::actions;
+   
+   auto &profiler = simulator.getHookProfiler();
+   
+   FirmwareSnapshot unprofiled_state;
+   simulator.takeSnapshot(unprofiled_state);
+   
+   //***************************************************************************
+   {
+      auto test = simulator.newTest("Profile hooks");
+      
+      profiler.setEnabled(true);
+      
+      simulator.cycles(100);
+      
+      PAPILIO_ASSERT_CONDITION(simulator, 
+         profiler.getNumHookCalls("MouseKeys", HookProfiler::before_each_cycle) == 100);
+      
+      simulator.tapKey(2, 1); // A
+      simulator.cycleExpectReports(AssertKeycodesActive{Key_A});
+      simulator.cycleExpectReports(AssertReportEmpty{});
+      
+      PAPILIO_ASSERT_CONDITION(simulator, 
+         profiler.getNumHookCalls("MouseKeys", HookProfiler::on_keyswitch_event) > 0);
+      
+      profiler.logResults(simulator);
+   }
+   
+   //***************************************************************************
+   {
+      auto test = simulator.newTest("Profile after restore");
+      
+      // The restore rolls the proxy back to a state in which 
+      // it was not registered with the profiler yet.
+      //
+      simulator.restoreSnapshot(unprofiled_state);
+      profiler.reset();
+      
+      simulator.cycles(10);
+      
+      PAPILIO_ASSERT_CONDITION(simulator, 
+         profiler.getNumHookCalls("MouseKeys", HookProfiler::before_each_cycle) == 10);
+      
+      profiler.setEnabled(false);
+      
+      simulator.cycles(10);
+      
+      PAPILIO_ASSERT_CONDITION(simulator, 
+         profiler.getNumHookCalls("MouseKeys", HookProfiler::before_each_cycle) == 10);
+   }
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
+
+#endif
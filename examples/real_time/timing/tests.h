@@ -19,9 +19,29 @@
 #ifdef KALEIDOSCOPE_VIRTUAL_BUILD
 
 #include "Kaleidoscope-Simulator.h"
+#include "kaleidoscope_simulator/Benchmark.h"
 
 #include <iostream>
-#include <ctime>
+#include <fstream>
+#include <string.h>
+
+// Usage: <binary> [--json <output file>]
+//
+// The benchmark results are written to the output file as JSON. 
+// Without it, they are written to stdout.
+//
+const char *json_output_path = nullptr;
+
+void parseCommandLine(int argc, char* argv[]) { 
+   for(int i = 1; i < argc; ++i) {
+      if((strcmp(argv[i], "--json") == 0) && (i + 1 < argc)) {
+         json_output_path = argv[++i];
+      }
+      else {
+         std::cerr << "Ignoring argument " << argv[i] << std::endl;
+      }
+   }
+}
    
 KALEIDOSCOPE_SIMULATOR_INIT
 
@@ -29,21 +49,72 @@ namespace kaleidoscope {
 namespace simulator {
    
 void runSimulator(Simulator &simulator) {
-
-   // Loop cycle timing
-   auto begin = std::clock();
    
-   static constexpr int n_cycles = 10000;
-   static constexpr double inv_clocks_per_sec = 1.0/CLOCKS_PER_SEC;
+   BenchmarkOptions options;
+   options.n_warmup_cycles = 1000;
+   options.n_trials = 10;
+   options.n_cycles_per_trial = 10000;
    
-   simulator.cycles(n_cycles);
-
-   auto end = std::clock();
-   double elapsed_secs = double(end - begin)*inv_clocks_per_sec;
-   double elapsed_secs_per_cycle = elapsed_secs/n_cycles;
+   Benchmark benchmark{simulator, options};
+   
+   // Nothing happens at all
+   //
+   benchmark.run("idle");
+   
+   // Idle with idle cycles being fast-forwarded
+   //
+   benchmark.run("idle_fast_forward",
+      [&]() { simulator.setIdleFastForward(true); }
+   );
+   simulator.setIdleFastForward(false);
+   
+   // A single key is held during the entire run
+   //
+   benchmark.run("held_key",
+      [&]() { simulator.pressKey(2, 1); } // A
+   );
+   
+   // A large chord is pressed and released in alternating cycles
+   //
+   KeyMatrix chord;
+   for(uint8_t col = 1; col < 7; ++col) {
+      chord.set(2, col);
+      chord.set(3, col);
+   }
+   
+   benchmark.run("chord_storm",
+      Benchmark::SetupFunction{},
+      [&](uint32_t) { simulator.togglePressedKeys(chord); }
+   );
+   
+   // The rainbow wave LED effect is active
+   //
+   benchmark.run("led_effect",
+      [&]() { 
+         simulator.multiTapKey(2 /*num. taps*/, 
+                               0 /*row*/, 6/*col*/, 
+                               1 /* num. cycles after each tap */
+         );
+      }
+   );
+   
+   benchmark.logResults();
    
-   simulator.log() << "elapsed [s]: " << elapsed_secs;
-   simulator.log() << "cycle duration: " << elapsed_secs_per_cycle;
+   if(json_output_path) {
+      std::ofstream json_file{json_output_path};
+      benchmark.writeJSON(json_file);
+      json_file.close();
+      if(json_file) {
+         simulator.log() << "Benchmark results written to " << json_output_path;
+      }
+      else {
+         simulator.error() << "Unable to write benchmark results to " 
+            << json_output_path;
+      }
+   }
+   else {
+      benchmark.writeJSON(std::cout);
+   }
 }
 
 } // namespace simulator
@@ -395,6 +395,18 @@ USE_MAGIC_COMBOS({.action = toggleKeyboardProtocol,
                   .keys = { R3C6, R2C6, R3C7 }
                  });
 
+// The profiling example profiles the hooks of the MouseKeys plugin
+// through a proxy (see examples/profiling). All other builds use 
+// the plugin directly.
+//
+#if defined(KALEIDOSCOPE_VIRTUAL_BUILD) && defined(KALEIDOSCOPE_SIMULATOR_PROFILE_MOUSE_KEYS)
+#include "kaleidoscope_simulator/ProfiledPlugin.h"
+KALEIDOSCOPE_SIMULATOR_PROFILED_PLUGIN(MouseKeys)
+#define MOUSE_KEYS_PLUGIN profiled_MouseKeys
+#else
+#define MOUSE_KEYS_PLUGIN MouseKeys
+#endif
+
 // First, tell Kaleidoscope which plugins you want to use.
 // The order can be important. For example, LED effects are
 // added in the order they're listed here.
@@ -467,7 +479,7 @@ KALEIDOSCOPE_INIT_PLUGINS(
   Macros,
 
   // The MouseKeys plugin lets you add keys to your keymap which move the mouse.
-  MouseKeys,
+  MOUSE_KEYS_PLUGIN,
 
   // The HostPowerManagement plugin allows us to turn LEDs off when then host
   // goes to sleep, and resume them when it wakes up.
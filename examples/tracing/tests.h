@@ -0,0 +1,176 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard 
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef KALEIDOSCOPE_VIRTUAL_BUILD
+
+#include "Kaleidoscope-Simulator.h"
+#include "kaleidoscope_simulator/vendors/keyboardio/model01.h"
+
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <exception>
+
+// Traces a few cycles and checks the trace file that results.
+   
+KALEIDOSCOPE_SIMULATOR_INIT
+
+namespace {
+   
+// Checks that brackets and string quotes of a JSON document are balanced
+// and that nothing follows the top level object.
+//
+bool isWellFormedJSON(const std::string &json)
+{
+   std::string open_brackets;
+   bool in_string = false;
+   bool escaped = false;
+   bool complete = false;
+   
+   for(const char c: json) {
+      
+      if(in_string) {
+         if(escaped) { escaped = false; }
+         else if(c == '\\') { escaped = true; }
+         else if(c == '\"') { in_string = false; }
+         continue;
+      }
+      
+      if(c == ' ' || c == '\n') { continue; }
+      
+      if(complete) { return false; }
+      
+      switch(c) {
+         case '\"':
+            in_string = true;
+            break;
+         case '{':
+         case '[':
+            open_brackets += c;
+            break;
+         case '}':
+         case ']':
+            if(open_brackets.empty() 
+                  || (open_brackets.back() != ((c == '}') ? '{' : '['))) {
+               return false;
+            }
+            open_brackets.pop_back();
+            complete = open_brackets.empty();
+            break;
+      }
+   }
+   
+   return complete && !in_string;
+}
+
+size_t countOccurrences(const std::string &text, const std::string &pattern)
+{
+   size_t n = 0;
+   for(auto pos = text.find(pattern); pos != std::string::npos; 
+       pos = text.find(pattern, pos + pattern.size())) {
+      ++n;
+   }
+   return n;
+}
+
+} // namespace
+
+namespace kaleidoscope {
+namespace simulator {
+   
+void runSimulator(Simulator &simulator) {
+   
+   using namespace kaleidoscope::simulator::actions;
+   using namespace papilio::actions;
+   
+   auto &trace_writer = simulator.getTraceWriter();
+   
+   //***************************************************************************
+   {
+      auto test = simulator.newTest("Trace cycles");
+      
+      const char *path = "trace_test.json";
+      
+      // A small flush threshold makes the writer flush 
+      // several times.
+      //
+      trace_writer.open(path, 256);
+      
+      simulator.cycles(10);
+      
+      simulator.tapKey(2, 1); // A
+      simulator.cycleExpectReports(AssertKeycodesActive{Key_A});
+      simulator.cycleExpectReports(AssertReportEmpty{});
+      
+      trace_writer.close();
+      
+      PAPILIO_ASSERT_CONDITION(simulator, !trace_writer.isOpen());
+      
+      std::ifstream in(path, std::ios::binary);
+      std::ostringstream content;
+      content << in.rdbuf();
+      std::string trace = content.str();
+      
+      remove(path);
+      
+      PAPILIO_ASSERT_CONDITION(simulator, isWellFormedJSON(trace));
+      
+      // Every event is written on a line of its own.
+      //
+      PAPILIO_ASSERT_CONDITION(simulator, 
+         countOccurrences(trace, "\n{\"ph\":\"X\",\"cat\":\"cycle\"") == 12);
+      PAPILIO_ASSERT_CONDITION(simulator, 
+         countOccurrences(trace, "\"name\":\"key_tapped\"") == 1);
+      PAPILIO_ASSERT_CONDITION(simulator, 
+         countOccurrences(trace, "\"name\":\"hid_report\"") >= 2);
+      
+      // The metadata records that precede the events are not counted.
+      //
+      PAPILIO_ASSERT_CONDITION(simulator, 
+         countOccurrences(trace, "\n{\"ph\":") == trace_writer.getNumEvents() + 1);
+   }
+   
+#ifdef __linux__
+   //***************************************************************************
+   {
+      auto test = simulator.newTest("Trace write error");
+      
+      // Every write to /dev/full fails as if the disk was full.
+      //
+      trace_writer.open("/dev/full", 256);
+      
+      bool error_reported = false;
+      try {
+         simulator.cycles(10);
+         trace_writer.close();
+      }
+      catch(const std::exception &) {
+         error_reported = true;
+      }
+      
+      PAPILIO_ASSERT_CONDITION(simulator, error_reported);
+      PAPILIO_ASSERT_CONDITION(simulator, !trace_writer.isOpen());
+   }
+#endif
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
+
+#endif
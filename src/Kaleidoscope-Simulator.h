@@ -32,11 +32,14 @@ uint8_t toKeycode(Key key) { return key.getKeyCode(); }
 
 #include "Papilio.h"
 #include "kaleidoscope_simulator/Simulator.h"
+#include "kaleidoscope_simulator/SimulatorCore.h"
+#include "kaleidoscope_simulator/FirmwareSnapshot.h"
 #include "kaleidoscope_simulator/AglaisInterface.h"
 #include "papilio/Visualization.h"
 
 #include "kaleidoscope_simulator/actions/AssertLayerIsActive.h"
 #include "kaleidoscope_simulator/actions/AssertTopActiveLayerIs.h"
+#include "kaleidoscope_simulator/actions/AssertKeycodesChanged.h"
 #include "kaleidoscope_simulator/actions/generic_report/GenerateHostEvent.h"
 
 #include <iostream>
@@ -62,5 +65,6 @@ extern void executeTestFunction();
    void executeTestFunction() {                                                \
       setup(); /* setup Kaleidoscope */                                        \
       using namespace kaleidoscope::simulator;                                 \
-      runSimulator(Simulator::getInstance());                                  \
+      Simulator simulator{std::cout};                                          \
+      runSimulator(simulator);                                                 \
    }
@@ -0,0 +1,127 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace kaleidoscope {
+namespace simulator {
+   
+/// @brief Definitions of the binary Aglais format.
+/// @details A binary document starts with the magic bytes "AGLB",
+///        followed by a version byte. A sequence of records follows,
+///        each starting with a tag byte. The document is terminated
+///        by an end record.
+///
+///        Unsigned integers are encoded as LEB128 varints. Cycle ids 
+///        and times are stored as zigzag encoded deltas to the 
+///        values expected from the preceding records. In typical 
+///        recordings most deltas are zero. 
+///
+///        Cycle durations are typically only a few milliseconds. 
+///        They are packed as pairs of 4 bit nibbles, the first duration
+///        of a pair in the low nibble. Durations that do not fit 
+///        are marked by the nibble value 15 (escape) and stored 
+///        as varints that follow the byte containing the nibbles. 
+///        If the number of durations is odd, the final high nibble
+///        is zero.
+///
+///        Records (fields after the tag):
+///
+///        firmware_id:  varint length, bytes
+///        start_cycle:  delta cycle id, delta time
+///        end_cycle:    delta cycle id, delta time
+///        cycles:       delta cycle id, delta start time, varint n, 
+///                      n packed durations
+///        key_pressed:  row byte, col byte
+///        key_released: row byte, col byte
+///        hid_report:   id byte, varint length, raw bytes
+///        set_time:     delta time
+///        end
+///
+namespace aglais_binary {
+   
+constexpr char magic[4] = { 'A', 'G', 'L', 'B' };
+constexpr uint8_t version = 1;
+
+enum Tag : uint8_t {
+   tag_end = 0,
+   tag_firmware_id,
+   tag_start_cycle,
+   tag_end_cycle,
+   tag_cycles,
+   tag_key_pressed,
+   tag_key_released,
+   tag_hid_report,
+   tag_set_time
+};
+
+/// @brief Checks whether a document is binary.
+/// @details Text documents that are shorter than the magic bytes
+///        are safely rejected if they are null terminated.
+/// @param data The document.
+/// @param size The number of bytes available.
+///
+inline bool isBinary(const char *data, size_t size) {
+   return (size >= sizeof(magic)) && (strncmp(data, magic, sizeof(magic)) == 0);
+}
+
+constexpr uint8_t nibble_escape = 15;
+
+inline uint32_t zigzagEncode(uint32_t value, uint32_t reference) {
+   int32_t delta = int32_t(value - reference);
+   return (uint32_t(delta) << 1) ^ uint32_t(delta >> 31);
+}
+
+inline uint32_t zigzagDecode(uint32_t encoded, uint32_t reference) {
+   uint32_t delta = (encoded >> 1) ^ (0 - (encoded & 1));
+   return reference + delta;
+}
+
+/// @brief The values that deltas are computed against.
+/// @details Writer and parser must update the state identically.
+///
+struct DeltaState {
+   
+   uint32_t next_cycle_id = 0;
+   uint32_t time = 0;
+   
+   void onStartCycle(uint32_t cycle_id, uint32_t start_time) {
+      next_cycle_id = cycle_id;
+      time = start_time;
+   }
+   void onEndCycle(uint32_t cycle_id, uint32_t end_time) {
+      next_cycle_id = cycle_id + 1;
+      time = end_time;
+   }
+   void onCycles(uint32_t start_cycle_id, uint32_t n_cycles, uint32_t end_time) {
+      next_cycle_id = start_cycle_id + n_cycles;
+      time = end_time;
+   }
+   void onSetTime(uint32_t new_time) {
+      time = new_time;
+   }
+};
+   
+} // namespace aglais_binary
+
+} // namespace simulator
+} // namespace kaleidoscope
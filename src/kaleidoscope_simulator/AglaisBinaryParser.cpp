@@ -0,0 +1,321 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/AglaisBinaryParser.h"
+#include "kaleidoscope_simulator/aux/exceptions.h"
+#include "aglais/Consumer_.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace kaleidoscope {
+namespace simulator {
+   
+using namespace aglais_binary;
+   
+   AglaisBinaryParser
+      ::AglaisBinaryParser(aglais::Consumer_ &consumer, 
+                           size_t buffer_size,
+                           size_t max_cycles_per_batch)
+   :  consumer_(consumer),
+      buffer_size_(std::max(buffer_size, size_t(512))),
+      max_cycles_per_batch_((max_cycles_per_batch > 0) ? max_cycles_per_batch : 1)
+{
+   cycle_durations_.reserve(std::min(max_cycles_per_batch_, size_t(4096)));
+}
+
+void AglaisBinaryParser::parse(const Source &source)
+{
+   if(!buffer_) {
+      buffer_.reset(new char[buffer_size_]);
+   }
+   
+   source_ = &source;
+   data_ = reinterpret_cast<const uint8_t*>(buffer_.get());
+   pos_ = 0;
+   end_ = 0;
+   eof_ = false;
+   consumed_ = 0;
+   
+   try {
+      this->parseDocument();
+   }
+   catch(...) {
+      source_ = nullptr;
+      throw;
+   }
+   
+   source_ = nullptr;
+}
+
+void AglaisBinaryParser::parse(std::istream &in)
+{
+   this->parse(AglaisStreamParser::makeSource(in));
+}
+
+void AglaisBinaryParser::parse(int fd)
+{
+   this->parse(AglaisStreamParser::makeSource(fd));
+}
+
+void AglaisBinaryParser::parse(const char *data, size_t size)
+{
+   source_ = nullptr;
+   data_ = reinterpret_cast<const uint8_t*>(data);
+   pos_ = 0;
+   end_ = size;
+   eof_ = true;
+   consumed_ = 0;
+   
+   this->parseDocument();
+}
+
+void AglaisBinaryParser::parseDocument()
+{
+   this->require(sizeof(magic) + 1, "header");
+   
+   if(!isBinary(reinterpret_cast<const char*>(data_ + pos_), sizeof(magic))) {
+      this->error("Not a binary Aglais document");
+   }
+   pos_ += sizeof(magic);
+   
+   auto doc_version = this->readByte("version");
+   if(doc_version != version) {
+      this->error("Unsupported version " + std::to_string(doc_version));
+   }
+   
+   state_ = DeltaState{};
+   
+   while(this->parseRecord()) {}
+}
+
+bool AglaisBinaryParser::parseRecord()
+{
+   auto tag = this->readByte("record tag");
+   
+   switch(tag) {
+      case tag_end:
+         return false;
+      case tag_firmware_id:
+         {
+            auto length = this->readVarint("firmware id length");
+            std::string firmware_id;
+            firmware_id.reserve(length);
+            for(uint32_t i = 0; i < length; ++i) {
+               firmware_id += char(this->readByte("firmware id"));
+            }
+            consumer_.onFirmwareId(firmware_id.c_str());
+         }
+         break;
+      case tag_start_cycle:
+         {
+            auto cycle_id = zigzagDecode(this->readVarint("cycle id"), state_.next_cycle_id);
+            auto time = zigzagDecode(this->readVarint("cycle start time"), state_.time);
+            state_.onStartCycle(cycle_id, time);
+            consumer_.onStartCycle(cycle_id, time);
+         }
+         break;
+      case tag_end_cycle:
+         {
+            auto cycle_id = zigzagDecode(this->readVarint("cycle id"), state_.next_cycle_id);
+            auto time = zigzagDecode(this->readVarint("cycle end time"), state_.time);
+            state_.onEndCycle(cycle_id, time);
+            consumer_.onEndCycle(cycle_id, time);
+         }
+         break;
+      case tag_cycles:
+         this->parseCycles();
+         break;
+      case tag_key_pressed:
+      case tag_key_released:
+         {
+            this->require(2, "key position");
+            uint8_t row = data_[pos_];
+            uint8_t col = data_[pos_ + 1];
+            pos_ += 2;
+            if(tag == tag_key_pressed) {
+               consumer_.onKeyPressed(row, col);
+            }
+            else {
+               consumer_.onKeyReleased(row, col);
+            }
+         }
+         break;
+      case tag_hid_report:
+         {
+            auto id = this->readByte("HID report id");
+            auto length = this->readVarint("HID report length");
+            if(length > 256) {
+               this->error("HID report too long");
+            }
+            
+            // The payload is passed to the consumer directly from
+            // the input buffer.
+            //
+            this->require(length, "HID report");
+            consumer_.onHIDReport(id, length, data_ + pos_);
+            pos_ += length;
+         }
+         break;
+      case tag_set_time:
+         {
+            auto time = zigzagDecode(this->readVarint("time"), state_.time);
+            state_.onSetTime(time);
+            consumer_.onSetTime(time);
+         }
+         break;
+      default:
+         this->error("Unknown record tag " + std::to_string(tag));
+   }
+   
+   return true;
+}
+
+void AglaisBinaryParser::parseCycles()
+{
+   auto cycle_id = zigzagDecode(this->readVarint("cycle id"), state_.next_cycle_id);
+   auto time = zigzagDecode(this->readVarint("cycle start time"), state_.time);
+   auto n_cycles = this->readVarint("number of cycles");
+   
+   auto batch_cycle_id = cycle_id;
+   auto batch_time = time;
+   
+   cycle_durations_.clear();
+   
+   uint8_t nibbles = 0;
+   
+   for(uint32_t i = 0; i < n_cycles; ++i) {
+      
+      // Every other duration starts a new byte of nibbles.
+      //
+      uint8_t nibble;
+      if(i % 2 == 0) {
+         nibbles = this->readByte("cycle durations");
+         nibble = nibbles & 0x0F;
+      }
+      else {
+         nibble = nibbles >> 4;
+      }
+      
+      uint32_t duration = (nibble == nibble_escape) 
+         ? this->readVarint("cycle duration")
+         : nibble;
+      
+      cycle_durations_.push_back(duration);
+      time += duration;
+      
+      if(cycle_durations_.size() == max_cycles_per_batch_) {
+         consumer_.onCycles(batch_cycle_id, batch_time, cycle_durations_);
+         batch_cycle_id += cycle_durations_.size();
+         batch_time = time;
+         cycle_durations_.clear();
+      }
+   }
+   
+   if(!cycle_durations_.empty()) {
+      consumer_.onCycles(batch_cycle_id, batch_time, cycle_durations_);
+   }
+   
+   state_.onCycles(cycle_id, n_cycles, time);
+}
+
+bool AglaisBinaryParser::ensure(size_t n)
+{
+   if(end_ - pos_ >= n) { return true; }
+   
+   while(end_ - pos_ < n) {
+      if(!this->refill()) { return false; }
+   }
+   return true;
+}
+
+void AglaisBinaryParser::require(size_t n, const char *what)
+{
+   if(!this->ensure(n)) {
+      this->error(std::string("Unexpected end of document, expected ") + what);
+   }
+}
+
+uint8_t AglaisBinaryParser::readByte(const char *what)
+{
+   if(pos_ == end_) {
+      this->require(1, what);
+   }
+   return data_[pos_++];
+}
+
+uint32_t AglaisBinaryParser::readVarint(const char *what)
+{
+   // A varint occupies at most five bytes. Near the end of the 
+   // document fewer bytes may be available.
+   //
+   if(end_ - pos_ < 5) {
+      this->ensure(5);
+   }
+   
+   uint32_t value = 0;
+   
+   for(int shift = 0; shift < 35; shift += 7) {
+      if(pos_ == end_) {
+         this->error(std::string("Unexpected end of document, expected ") + what);
+      }
+      uint8_t byte = data_[pos_++];
+      value |= uint32_t(byte & 0x7F) << shift;
+      if(!(byte & 0x80)) {
+         return value;
+      }
+   }
+   
+   this->error(std::string("Malformed varint for ") + what);
+}
+
+bool AglaisBinaryParser::refill()
+{
+   if(eof_ || !source_) {
+      eof_ = true;
+      return false;
+   }
+   
+   // Keep the data that has not been consumed yet.
+   //
+   char *buffer = buffer_.get();
+   size_t remaining = end_ - pos_;
+   memmove(buffer, buffer + pos_, remaining);
+   consumed_ += pos_;
+   pos_ = 0;
+   end_ = remaining;
+   
+   size_t n = (*source_)(buffer + end_, buffer_size_ - end_);
+   
+   if(n == 0) {
+      eof_ = true;
+      return false;
+   }
+   
+   end_ += n;
+   
+   return true;
+}
+
+void AglaisBinaryParser::error(const std::string &what) const
+{
+   KS_T_EXCEPTION("Aglais: offset " << this->getOffset() << ": " << what)
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
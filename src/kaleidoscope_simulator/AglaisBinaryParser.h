@@ -0,0 +1,123 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "kaleidoscope_simulator/AglaisStreamParser.h"
+#include "kaleidoscope_simulator/AglaisBinaryFormat.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace aglais {
+class Consumer_;
+} // namespace aglais
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief A parser for binary Aglais documents.
+/// @details See AglaisBinaryFormat.h for a description of the format.
+///        Like the AglaisStreamParser, the parser reads its input 
+///        incrementally into a buffer of fixed size.
+///
+class AglaisBinaryParser
+{
+   public:
+      
+      typedef AglaisStreamParser::Source Source;
+      
+      /// @brief Constructor.
+      /// @param consumer The consumer that receives the parsed commands.
+      /// @param buffer_size The size of the input buffer in bytes.
+      /// @param max_cycles_per_batch The max. number of cycle durations
+      ///        that are passed to the consumer with a single call 
+      ///        to onCycles.
+      ///
+      AglaisBinaryParser(aglais::Consumer_ &consumer, 
+                         size_t buffer_size = 64*1024,
+                         size_t max_cycles_per_batch = 4096);
+      
+      /// @brief Parses a document that is provided by a source function.
+      ///
+      void parse(const Source &source);
+      
+      /// @brief Parses a document that is read from a stream.
+      ///
+      void parse(std::istream &in);
+      
+      /// @brief Parses a document that is read from a file descriptor.
+      ///
+      void parse(int fd);
+      
+      /// @brief Parses a document that resides in memory.
+      /// @details The document is parsed in place without being copied.
+      /// @param data The document.
+      /// @param size The size of the document in bytes. Parsing
+      ///        stops at the end record. Thus, the size may be
+      ///        larger than the actual document if the
+      ///        document is known to be complete.
+      ///
+      void parse(const char *data, size_t size);
+      
+      /// @brief Retreives the offset of the current read position 
+      ///        relative to the start of the document.
+      ///
+      uint64_t getOffset() const { return consumed_ + pos_; }
+      
+   private:
+      
+      void parseDocument();
+      bool parseRecord();
+      void parseCycles();
+      
+      bool ensure(size_t n);
+      void require(size_t n, const char *what);
+      uint8_t readByte(const char *what);
+      uint32_t readVarint(const char *what);
+      
+      bool refill();
+      
+      [[noreturn]] void error(const std::string &what) const;
+      
+   private:
+      
+      aglais::Consumer_ &consumer_;
+      
+      size_t buffer_size_;
+      std::unique_ptr<char[]> buffer_;
+      const Source *source_ = nullptr;
+      
+      const uint8_t *data_ = nullptr;
+      size_t pos_ = 0;
+      size_t end_ = 0;
+      bool eof_ = false;
+      uint64_t consumed_ = 0;
+      
+      aglais_binary::DeltaState state_;
+      
+      size_t max_cycles_per_batch_;
+      std::vector<uint32_t> cycle_durations_;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
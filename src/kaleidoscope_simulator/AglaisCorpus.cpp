@@ -0,0 +1,271 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/AglaisCorpus.h"
+#include "kaleidoscope_simulator/AglaisDivergence.h"
+#include "kaleidoscope_simulator/AglaisInterface.h"
+#include "kaleidoscope_simulator/Simulator.h"
+#include "kaleidoscope_simulator/SimulatorCore.h"
+#include "kaleidoscope_simulator/FirmwareSnapshot.h"
+#include "kaleidoscope_simulator/WorkerPool.h"
+#include "kaleidoscope_simulator/aux/exceptions.h"
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+#ifdef __unix__
+#include <dirent.h>
+#include <errno.h>
+#endif
+
+namespace kaleidoscope {
+namespace simulator {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+uint64_t nanosecondsSince(Clock::time_point start)
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - start).count();
+}
+
+bool hasExtension(const std::string &name, const char *extension)
+{
+   size_t length = strlen(extension);
+   return (name.size() > length)
+       && (name.compare(name.size() - length, length, extension) == 0);
+}
+
+} // namespace
+
+   AglaisCorpusRunner
+      ::AglaisCorpusRunner(Simulator &simulator, const AglaisCorpusOptions &options)
+   :  simulator_(simulator),
+      options_(options)
+{
+}
+
+void AglaisCorpusRunner::addRecording(const char *path)
+{
+   paths_.push_back(path);
+}
+
+size_t AglaisCorpusRunner::addDirectory(const char *path)
+{
+#ifdef __unix__
+   DIR *dir = opendir(path);
+   if(!dir) {
+      KS_T_EXCEPTION("Unable to open directory \'" << path << "\': " << strerror(errno))
+   }
+
+   std::vector<std::string> names;
+
+   while(struct dirent *entry = readdir(dir)) {
+      std::string name = entry->d_name;
+      if(hasExtension(name, ".agl") || hasExtension(name, ".aglb")) {
+         names.push_back(name);
+      }
+   }
+
+   closedir(dir);
+
+   std::sort(names.begin(), names.end());
+
+   std::string prefix = path;
+   if(!prefix.empty() && (prefix.back() != '/')) {
+      prefix += '/';
+   }
+
+   for(const auto &name: names) {
+      paths_.push_back(prefix + name);
+   }
+
+   return names.size();
+#else
+   KS_T_EXCEPTION("Reading directories is not supported on this platform")
+#endif
+}
+
+bool AglaisCorpusRunner::run()
+{
+   results_.clear();
+
+   auto start = Clock::now();
+
+   WorkerPool pool{options_.max_workers};
+
+   // A worker returns the number of errors, the number of
+   // cycles and the replay time.
+   //
+   auto outputs = pool.run(paths_.size(), [&](size_t job_id) {
+
+      this->discardTrace();
+
+      auto replay_start = Clock::now();
+      auto start_cycle = simulator_.getSimulatorCore().getCycleCount();
+
+      size_t n_errors = processAglaisFile(paths_[job_id].c_str(), simulator_);
+
+      std::ostringstream out;
+      out << n_errors << ' ' 
+          << (simulator_.getSimulatorCore().getCycleCount() - start_cycle) << ' '
+          << nanosecondsSince(replay_start) << '\n';
+
+      return out.str();
+   });
+
+   duration_ns_ = nanosecondsSince(start);
+
+   std::vector<size_t> failing;
+
+   for(size_t i = 0; i < paths_.size(); ++i) {
+
+      AglaisRecordingResult result;
+      result.path = paths_[i];
+
+      const auto &output = outputs[i];
+
+      if(output.success) {
+         std::istringstream in{output.output};
+         size_t n_errors = 0;
+         in >> n_errors >> result.n_cycles >> result.duration_ns;
+         result.passed = (n_errors == 0);
+         if(!result.passed) {
+            result.message = std::to_string(n_errors) + " error(s) during the replay\n";
+         }
+      }
+      else {
+         result.message = output.output;
+      }
+
+      if(!result.passed) {
+         failing.push_back(i);
+      }
+
+      results_.push_back(std::move(result));
+   }
+
+   this->findDivergences(failing);
+
+   for(const auto i: failing) {
+      simulator_.error() << "Aglais corpus: " << results_[i].path << " failed: "
+         << results_[i].message;
+   }
+
+   return failing.empty();
+}
+
+void AglaisCorpusRunner::findDivergences(const std::vector<size_t> &failing)
+{
+   // The search replays from firmware checkpoints.
+   //
+   if(failing.empty() || !FirmwareSnapshot::isSupported()) { return; }
+
+   AglaisDivergenceOptions divergence_options;
+   divergence_options.checkpoint_interval = options_.checkpoint_interval;
+
+   WorkerPool pool{options_.max_workers};
+
+   auto outputs = pool.run(failing.size(), [&](size_t job_id) {
+
+      this->discardTrace();
+
+      auto divergence = findAglaisDivergenceInFile(paths_[failing[job_id]].c_str(),
+                                                   simulator_, divergence_options);
+
+      std::ostringstream out;
+      if(divergence.found) {
+         out << "First divergence in cycle " << divergence.cycle_id
+             << " (time " << divergence.time << ")\n"
+             << divergence.input_events << divergence.report_diff;
+      }
+
+      return out.str();
+   });
+
+   for(size_t i = 0; i < failing.size(); ++i) {
+      auto &result = results_[failing[i]];
+      const auto &output = outputs[i];
+      if(output.success) {
+         result.message += output.output;
+      }
+      else {
+         result.message += "Unable to find the divergence: " + output.output;
+      }
+   }
+}
+
+void AglaisCorpusRunner::discardTrace()
+{
+   // The trace belongs to the calling process.
+   //
+   if(simulator_.getTraceWriter().isOpen()) {
+      simulator_.getTraceWriter().discard();
+   }
+}
+
+void AglaisCorpusRunner::logResults() const
+{
+   size_t n_passed = 0;
+   uint64_t n_cycles = 0;
+
+   for(const auto &result: results_) {
+      if(result.passed) { ++n_passed; }
+      n_cycles += result.n_cycles;
+   }
+
+   double seconds = 1e-9*duration_ns_;
+
+   simulator_.log() << "Aglais corpus: " << n_passed << " of " << results_.size()
+      << " recordings passed, " << n_cycles << " cycles in " << seconds << " s";
+
+   if(seconds > 0.0) {
+      simulator_.log() << "   throughput: " << (n_cycles/seconds) << " cycles/s, "
+         << (results_.size()/seconds) << " recordings/s";
+   }
+
+   std::vector<const AglaisRecordingResult*> slowest;
+   for(const auto &result: results_) {
+      slowest.push_back(&result);
+   }
+
+   size_t n_slowest = std::min(options_.n_slowest, slowest.size());
+
+   std::partial_sort(slowest.begin(), slowest.begin() + n_slowest, slowest.end(),
+      [](const AglaisRecordingResult *a, const AglaisRecordingResult *b) {
+         return a->duration_ns > b->duration_ns;
+      }
+   );
+
+   if(n_slowest > 0) {
+      simulator_.log() << "   slowest recordings:";
+   }
+
+   for(size_t i = 0; i < n_slowest; ++i) {
+      const auto &result = *slowest[i];
+      simulator_.log() << "      " << result.path << ": "
+         << (1e-6*result.duration_ns) << " ms, " << result.n_cycles << " cycles";
+   }
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,147 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace kaleidoscope {
+namespace simulator {
+
+class Simulator;
+
+/// @brief Configuration of a corpus run.
+///
+struct AglaisCorpusOptions
+{
+   /// @brief The max. number of concurrent worker processes.
+   /// @details Zero selects the number of online processors.
+   ///
+   unsigned max_workers = 0;
+
+   /// @brief The number of cycles between two firmware checkpoints
+   ///        of the divergence search for failing recordings
+   ///        (see findAglaisDivergence(...)).
+   ///
+   uint32_t checkpoint_interval = 100000;
+
+   /// @brief The number of slowest recordings that are reported.
+   ///
+   size_t n_slowest = 10;
+};
+
+/// @brief The outcome of the replay of a single recording.
+///
+struct AglaisRecordingResult
+{
+   std::string path;
+
+   /// @brief True if the replay matched the recording.
+   ///
+   bool passed = false;
+
+   /// @brief The number of cycles replayed.
+   ///
+   uint64_t n_cycles = 0;
+
+   /// @brief The wall clock time of the replay in nanoseconds.
+   ///
+   uint64_t duration_ns = 0;
+
+   /// @brief The number of errors of a failing replay, followed by
+   ///        a description of the first divergence, or the
+   ///        error that stopped the replay.
+   ///
+   std::string message;
+};
+
+/// @brief Replays a corpus of Aglais recordings in parallel.
+/// @details Every recording is replayed in a worker process
+///        (see WorkerPool) that starts from the firmware state
+///        that is present when run() is called. A recording passes
+///        if it is replayed without errors (see processAglaisFile(...)).
+///        For failing recordings, the first divergence is 
+///        searched afterwards (see findAglaisDivergence(...)). 
+///        The search is skipped on platforms without
+///        firmware snapshots.
+///
+class AglaisCorpusRunner
+{
+   public:
+
+      /// @brief Constructor.
+      /// @param simulator The simulator to replay the recordings with.
+      /// @param options The corpus run configuration.
+      ///
+      AglaisCorpusRunner(Simulator &simulator,
+                         const AglaisCorpusOptions &options = AglaisCorpusOptions{});
+
+      /// @brief Adds a recording to the corpus.
+      /// @param path The path of the recording.
+      ///
+      void addRecording(const char *path);
+
+      /// @brief Adds all recordings of a directory to the corpus.
+      /// @details Files with extension .agl and .aglb are added in
+      ///        alphabetical order. Subdirectories are not searched.
+      ///        Throws if the directory can not be read.
+      /// @param path The path of the directory.
+      /// @returns The number of recordings added.
+      ///
+      size_t addDirectory(const char *path);
+
+      /// @brief Replays all recordings of the corpus.
+      /// @details Failing recordings are reported as errors
+      ///        through the simulator.
+      /// @returns True if all recordings passed.
+      ///
+      bool run();
+
+      /// @brief Writes a summary with throughput and the slowest
+      ///        recordings to the simulator's log.
+      ///
+      void logResults() const;
+
+      /// @brief Access the results of the last run, in the order
+      ///        the recordings were added.
+      ///
+      const std::vector<AglaisRecordingResult> &getResults() const { return results_; }
+
+      /// @brief Retreives the wall clock time of the last run in nanoseconds.
+      ///
+      uint64_t getDurationNs() const { return duration_ns_; }
+
+   private:
+
+      void findDivergences(const std::vector<size_t> &failing);
+      void discardTrace();
+
+   private:
+
+      Simulator &simulator_;
+      AglaisCorpusOptions options_;
+      std::vector<std::string> paths_;
+      std::vector<AglaisRecordingResult> results_;
+      uint64_t duration_ns_ = 0;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
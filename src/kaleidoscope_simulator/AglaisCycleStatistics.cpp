@@ -0,0 +1,170 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/AglaisCycleStatistics.h"
+#include "papilio/Simulator.h"
+
+#include <math.h>
+#include <algorithm>
+
+namespace kaleidoscope {
+namespace simulator {
+
+constexpr uint32_t CycleDurationStatistics::max_histogram_duration;
+
+namespace {
+
+const char *activity_names[] = { "idle", "key_events", "led_effect" };
+
+} // namespace
+
+double CycleDurationStatistics::getMean() const
+{
+   return (n_cycles > 0) ? double(sum)/n_cycles : 0.0;
+}
+
+double CycleDurationStatistics::getStdDev() const
+{
+   if(n_cycles < 2) { return 0.0; }
+
+   double mean = this->getMean();
+   double variance = (double(sum_of_squares) - n_cycles*mean*mean)/(n_cycles - 1);
+
+   return (variance > 0.0) ? sqrt(variance) : 0.0;
+}
+
+double CycleDurationStatistics::getJitter() const
+{
+   return (n_jumps > 0) ? double(sum_of_jumps)/n_jumps : 0.0;
+}
+
+uint32_t CycleDurationStatistics::getPercentile(double fraction) const
+{
+   uint64_t threshold = uint64_t(ceil(fraction*n_cycles));
+   uint64_t count = 0;
+
+   for(size_t i = 0; i < histogram.size(); ++i) {
+      count += histogram[i];
+      if((count > 0) && (count >= threshold)) {
+         return (i == max_histogram_duration) ? max : uint32_t(i);
+      }
+   }
+
+   return max;
+}
+
+   AglaisCycleStatistics
+      ::AglaisCycleStatistics()
+{
+   this->clear();
+}
+
+void AglaisCycleStatistics::addCycle(uint32_t duration, CycleActivity activity)
+{
+   auto &s = statistics_[int(activity)];
+   auto &previous = previous_duration_[int(activity)];
+
+   if(s.n_cycles > 0) {
+      s.sum_of_jumps += (duration > previous) ? duration - previous : previous - duration;
+      ++s.n_jumps;
+   }
+   previous = duration;
+
+   ++s.n_cycles;
+   s.sum += duration;
+   s.sum_of_squares += uint64_t(duration)*duration;
+   s.min = std::min(s.min, duration);
+   s.max = std::max(s.max, duration);
+
+   ++s.histogram[std::min(duration, CycleDurationStatistics::max_histogram_duration)];
+}
+
+void AglaisCycleStatistics::clear()
+{
+   for(int i = 0; i < int(CycleActivity::n_activities); ++i) {
+      statistics_[i] = CycleDurationStatistics{};
+      statistics_[i].histogram.resize(CycleDurationStatistics::max_histogram_duration + 1);
+      previous_duration_[i] = 0;
+   }
+}
+
+void AglaisCycleStatistics::onStartCycle(uint32_t cycle_id, uint32_t cycle_start_time)
+{
+   cycle_start_time_ = cycle_start_time;
+   cycle_active_ = false;
+}
+
+void AglaisCycleStatistics::onEndCycle(uint32_t cycle_id, uint32_t cycle_end_time)
+{
+   this->addCycle(cycle_end_time - cycle_start_time_,
+                  cycle_active_ ? CycleActivity::key_events : CycleActivity::idle);
+}
+
+void AglaisCycleStatistics::onCycles(uint32_t start_cycle_id, uint32_t start_time_id,
+                                     const std::vector<uint32_t> &cycle_durations)
+{
+   for(const auto duration: cycle_durations) {
+      this->addCycle(duration, CycleActivity::idle);
+   }
+}
+
+void AglaisCycleStatistics::logResults(papilio::Simulator &simulator) const
+{
+   for(int i = 0; i < int(CycleActivity::n_activities); ++i) {
+
+      const auto &s = statistics_[i];
+      if(s.n_cycles == 0) { continue; }
+
+      simulator.log() << "Cycle durations " << activity_names[i] << ": "
+         << s.n_cycles << " cycles";
+      simulator.log() << "   mean [ms]: " << s.getMean() << " +- " << s.getStdDev()
+         << ", jitter [ms]: " << s.getJitter();
+      simulator.log() << "   min/p50/p90/p99/max [ms]: " << s.min << '/'
+         << s.getPercentile(0.5) << '/' << s.getPercentile(0.9) << '/'
+         << s.getPercentile(0.99) << '/' << s.max;
+   }
+}
+
+void AglaisCycleStatistics::writeJSON(std::ostream &out) const
+{
+   out << "{\n";
+
+   for(int i = 0; i < int(CycleActivity::n_activities); ++i) {
+
+      const auto &s = statistics_[i];
+
+      out << "  \"" << activity_names[i] << "\": {\n";
+      out << "    \"cycles\": " << s.n_cycles << ",\n";
+      out << "    \"mean_ms\": " << s.getMean() << ",\n";
+      out << "    \"stddev_ms\": " << s.getStdDev() << ",\n";
+      out << "    \"jitter_ms\": " << s.getJitter() << ",\n";
+      out << "    \"min_ms\": " << ((s.n_cycles > 0) ? s.min : 0) << ",\n";
+      out << "    \"max_ms\": " << s.max << ",\n";
+      out << "    \"histogram_ms\": [";
+      for(size_t j = 0; j < s.histogram.size(); ++j) {
+         out << (j ? ", " : "") << s.histogram[j];
+      }
+      out << "]\n";
+      out << "  }" << ((i + 1 < int(CycleActivity::n_activities)) ? "," : "") << "\n";
+   }
+
+   out << "}\n";
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,158 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "aglais/Consumer_.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ostream>
+#include <vector>
+
+namespace papilio {
+class Simulator;
+} // namespace papilio
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief What happened during a recorded cycle.
+///
+enum class CycleActivity {
+   idle,          ///< Nothing happened.
+   key_events,    ///< Keys were pressed or released or reports were emitted.
+   led_effect,    ///< Only the LEDs changed.
+   n_activities
+};
+
+/// @brief Statistics of the durations of the cycles of one activity.
+/// @details Durations are the ones measured on the device,
+///        with millisecond resolution.
+///
+struct CycleDurationStatistics
+{
+   /// @brief The largest duration [ms] with a histogram bucket of its own.
+   ///        Longer cycles are counted in the last bucket.
+   ///
+   static constexpr uint32_t max_histogram_duration = 63;
+
+   uint64_t n_cycles = 0;
+   uint64_t sum = 0;
+   uint64_t sum_of_squares = 0;
+   uint32_t min = 0xFFFFFFFF;
+   uint32_t max = 0;
+
+   /// @brief The sum of the absolute differences of the durations
+   ///        of consecutive cycles of this activity.
+   ///
+   uint64_t sum_of_jumps = 0;
+   uint64_t n_jumps = 0;
+
+   /// @brief Bucket i counts cycles that took i ms.
+   ///
+   std::vector<uint64_t> histogram;
+
+   /// @brief The mean duration [ms].
+   ///
+   double getMean() const;
+
+   /// @brief The standard deviation of the duration [ms].
+   ///
+   double getStdDev() const;
+
+   /// @brief The mean absolute difference [ms] of the durations
+   ///        of consecutive cycles.
+   ///
+   double getJitter() const;
+
+   /// @brief The duration [ms] that a given fraction of all cycles
+   ///        does not exceed.
+   /// @param fraction The fraction, e.g. 0.99.
+   ///
+   uint32_t getPercentile(double fraction) const;
+};
+
+/// @brief Aggregates the cycle durations of Aglais recordings.
+/// @details Every cycle's duration is recorded with the activity
+///        that happened during the cycle. A cycle counts as
+///        key_events cycle if the recording shows key actions or
+///        HID reports for it. LED effects are only known while
+///        a recording is replayed, see setAglaisCycleStatistics(...).
+///
+///        The object is also an Aglais consumer. To analyze
+///        a recording without simulating it, pass it to
+///        parseAglaisDocument(...). All cycles without key events
+///        then count as idle.
+///
+class AglaisCycleStatistics : public aglais::Consumer_
+{
+   public:
+
+      AglaisCycleStatistics();
+
+      /// @brief Records the duration of a cycle.
+      /// @param duration The duration [ms].
+      /// @param activity What happened during the cycle.
+      ///
+      void addCycle(uint32_t duration, CycleActivity activity);
+
+      /// @brief Access the statistics of one activity.
+      ///
+      const CycleDurationStatistics &get(CycleActivity activity) const {
+         return statistics_[int(activity)];
+      }
+
+      /// @brief Removes all recorded cycles.
+      ///
+      void clear();
+
+      /// @brief Writes a human readable table of the statistics to
+      ///        a simulator's log.
+      /// @param simulator The simulator.
+      ///
+      void logResults(papilio::Simulator &simulator) const;
+
+      /// @brief Writes the statistics as JSON.
+      /// @param out The stream to write to.
+      ///
+      void writeJSON(std::ostream &out) const;
+
+      virtual void onFirmwareId(const char *firmware_id) override {}
+      virtual void onStartCycle(uint32_t cycle_id, uint32_t cycle_start_time) override;
+      virtual void onEndCycle(uint32_t cycle_id, uint32_t cycle_end_time) override;
+      virtual void onKeyPressed(uint8_t row, uint8_t col) override { cycle_active_ = true; }
+      virtual void onKeyReleased(uint8_t row, uint8_t col) override { cycle_active_ = true; }
+      virtual void onHIDReport(uint8_t id, int length, const uint8_t *data) override {
+         cycle_active_ = true;
+      }
+      virtual void onSetTime(uint32_t time) override {}
+      virtual void onCycles(uint32_t start_cycle_id, uint32_t start_time_id,
+                            const std::vector<uint32_t> &cycle_durations) override;
+
+   private:
+
+      CycleDurationStatistics statistics_[int(CycleActivity::n_activities)];
+      uint32_t previous_duration_[int(CycleActivity::n_activities)];
+
+      uint32_t cycle_start_time_ = 0;
+      bool cycle_active_ = false;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
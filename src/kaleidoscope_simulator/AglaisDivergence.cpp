@@ -0,0 +1,317 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/AglaisDivergence.h"
+#include "kaleidoscope_simulator/AglaisInterface.h"
+#include "kaleidoscope_simulator/AglaisWriter.h"
+#include "kaleidoscope_simulator/ExpectedReportStream.h"
+#include "kaleidoscope_simulator/FirmwareSnapshot.h"
+#include "kaleidoscope_simulator/MappedFile.h"
+#include "kaleidoscope_simulator/Simulator.h"
+#include "aglais/Consumer_.h"
+
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace kaleidoscope {
+namespace simulator {
+
+namespace {
+
+// Thrown to stop parsing at the first divergence.
+//
+struct Diverged {};
+
+// Replays a document quietly and checkpoints the firmware at regular
+// intervals. The commands since the last checkpoint are recorded as
+// a binary Aglais document.
+//
+class DivergenceFinder : public aglais::Consumer_
+{
+   public:
+
+      DivergenceFinder(Simulator &simulator, uint32_t checkpoint_interval,
+                       AglaisDivergence &result)
+         :  simulator_(simulator),
+            checkpoint_interval_(checkpoint_interval ? checkpoint_interval : 1),
+            result_(result),
+            previous_hook_(simulator.getHIDReportHook())
+      {
+         simulator_.setHIDReportHook(
+            [this](uint8_t id, const uint8_t *data, int length) {
+               if(previous_hook_) { previous_hook_(id, data, length); }
+               emitted_.push(id, length, data);
+            }
+         );
+      }
+
+      ~DivergenceFinder() {
+         simulator_.setHIDReportHook(std::move(previous_hook_));
+      }
+
+      virtual void onFirmwareId(const char *firmware_id) override {}
+
+      virtual void onStartCycle(uint32_t cycle_id, uint32_t cycle_start_time) override {
+         if(cycle_pos_ % checkpoint_interval_ == 0) {
+            this->checkpoint(cycle_id);
+         }
+         writer_->onStartCycle(cycle_id, cycle_start_time);
+
+         cycle_time_ = cycle_start_time;
+         input_events_.clear();
+         simulator_.setTime(cycle_start_time);
+      }
+      virtual void onEndCycle(uint32_t cycle_id, uint32_t cycle_end_time) override {
+         writer_->onEndCycle(cycle_id, cycle_end_time);
+
+         emitted_.clear();
+         simulator_.cycle(true /*suppress cycle log info*/);
+         ++cycle_pos_;
+         this->verifyCycle(cycle_id, cycle_time_);
+
+         simulator_.setTime(cycle_end_time);
+      }
+      virtual void onKeyPressed(uint8_t row, uint8_t col) override {
+         this->ensureWindow();
+         writer_->onKeyPressed(row, col);
+         input_events_ += "key_pressed " + std::to_string(row)
+                        + ' ' + std::to_string(col) + '\n';
+         simulator_.pressKey(row, col);
+      }
+      virtual void onKeyReleased(uint8_t row, uint8_t col) override {
+         this->ensureWindow();
+         writer_->onKeyReleased(row, col);
+         input_events_ += "key_released " + std::to_string(row)
+                        + ' ' + std::to_string(col) + '\n';
+         simulator_.releaseKey(row, col);
+      }
+      virtual void onHIDReport(uint8_t id, int length, const uint8_t *data) override {
+         this->ensureWindow();
+         writer_->onHIDReport(id, length, data);
+         expected_.push(id, length, data);
+      }
+      virtual void onSetTime(uint32_t time) override {
+         this->ensureWindow();
+         writer_->onSetTime(time);
+         simulator_.setTime(time);
+      }
+      virtual void onCycles(uint32_t start_cycle_id, uint32_t start_time_id,
+                               const std::vector<uint32_t> &cycle_durations) override {
+
+         // The part of the run that follows the last checkpoint
+         // is recorded as a run of its own.
+         //
+         size_t window_begin = 0;
+         uint32_t window_time = start_time_id;
+
+         auto cycle_time = start_time_id;
+
+         for(size_t i = 0; i < cycle_durations.size(); ++i) {
+
+            uint32_t cycle_id = start_cycle_id + i;
+
+            if(cycle_pos_ % checkpoint_interval_ == 0) {
+               this->checkpoint(cycle_id);
+               window_begin = i;
+               window_time = cycle_time;
+            }
+
+            input_events_.clear();
+            emitted_.clear();
+
+            simulator_.setTime(cycle_time);
+            simulator_.cycle(true /*suppress cycle log info*/);
+
+            ++cycle_pos_;
+            cycle_time += cycle_durations[i];
+
+            // Runs of cycles come without reactions. Thus, any
+            // report diverges.
+            //
+            if(!emitted_.empty()) {
+               this->recordCycles(start_cycle_id + window_begin, window_time,
+                                  cycle_durations, window_begin, i + 1);
+               this->verifyCycle(cycle_id, cycle_time - cycle_durations[i]);
+            }
+         }
+
+         this->ensureWindow();
+         this->recordCycles(start_cycle_id + window_begin, window_time,
+                            cycle_durations, window_begin, cycle_durations.size());
+
+         simulator_.setTime(cycle_time);
+      }
+
+      const FirmwareSnapshot &getCheckpoint() const { return checkpoint_; }
+
+      uint64_t getNumCycles() const { return cycle_pos_; }
+
+      // Completes the recording of the window that ends with
+      // the diverging cycle.
+      //
+      std::string finishWindow() {
+         writer_->finish();
+         return window_.str();
+      }
+
+   private:
+
+      void checkpoint(uint32_t cycle_id) {
+         simulator_.takeSnapshot(checkpoint_);
+         writer_.reset();
+         window_.str(std::string{});
+         writer_.reset(new AglaisBinaryWriter{window_});
+         result_.checkpoint_cycle_id = cycle_id;
+      }
+
+      // Commands that precede the first cycle are replayed from
+      // the initial state.
+      //
+      void ensureWindow() {
+         if(!writer_) { this->checkpoint(0); }
+      }
+
+      void recordCycles(uint32_t start_cycle_id, uint32_t start_time,
+                        const std::vector<uint32_t> &cycle_durations,
+                        size_t begin, size_t end) {
+         if(begin == end) { return; }
+
+         if((begin == 0) && (end == cycle_durations.size())) {
+            writer_->onCycles(start_cycle_id, start_time, cycle_durations);
+            return;
+         }
+
+         durations_.assign(cycle_durations.begin() + begin,
+                           cycle_durations.begin() + end);
+         writer_->onCycles(start_cycle_id, start_time, durations_);
+      }
+
+      void verifyCycle(uint32_t cycle_id, uint32_t time) {
+
+         differences_.clear();
+         if(expected_.verifyCycle(emitted_, differences_) == 0) { return; }
+
+         std::string diff;
+         for(const auto &difference: differences_) {
+            diff += difference;
+            diff += '\n';
+         }
+
+         result_.found = true;
+         result_.cycle_id = cycle_id;
+         result_.time = time;
+         result_.input_events = input_events_;
+         result_.report_diff = diff;
+
+         throw Diverged{};
+      }
+
+   private:
+
+      Simulator &simulator_;
+      uint32_t checkpoint_interval_;
+      AglaisDivergence &result_;
+      Simulator::HIDReportHook previous_hook_;
+
+      FirmwareSnapshot checkpoint_;
+      std::ostringstream window_;
+      std::unique_ptr<AglaisBinaryWriter> writer_;
+      std::vector<uint32_t> durations_;
+
+      ExpectedReportStream expected_;
+      ExpectedReportStream emitted_;
+      std::vector<std::string> differences_;
+
+      uint64_t cycle_pos_ = 0;
+      uint32_t cycle_time_ = 0;
+      std::string input_events_;
+};
+
+} // namespace
+
+AglaisDivergence findAglaisDivergence(const char *data, size_t size,
+                                      Simulator &simulator,
+                                      const AglaisDivergenceOptions &options)
+{
+   AglaisDivergence result;
+   std::string window;
+
+   auto rwqa_state = simulator.getErrorIfReportWithoutQueuedActions();
+   simulator.setErrorIfReportWithoutQueuedActions(false);
+
+   {
+      DivergenceFinder finder{simulator, options.checkpoint_interval, result};
+
+      try {
+         parseAglaisDocument(data, size, finder);
+      }
+      catch(const Diverged &) {
+
+         window = finder.finishWindow();
+
+         // Go back to the last checkpoint. The snapshot does not
+         // survive the finder.
+         //
+         simulator.restoreSnapshot(finder.getCheckpoint());
+      }
+
+      result.n_cycles = finder.getNumCycles();
+   }
+
+   simulator.setErrorIfReportWithoutQueuedActions(rwqa_state);
+
+   if(!result.found) {
+      return result;
+   }
+
+   simulator.log() << "Aglais: First divergence in cycle " << result.cycle_id
+      << " (time " << result.time << "), replaying from cycle "
+      << result.checkpoint_cycle_id;
+
+   auto log_level = getAglaisLogLevel();
+   setAglaisLogLevel(AglaisLogLevel::reactions);
+
+   auto &trace_writer = simulator.getTraceWriter();
+   bool tracing = (options.trace_path != nullptr) && !trace_writer.isOpen();
+   if(tracing) {
+      trace_writer.open(options.trace_path);
+   }
+
+   processAglaisDocument(window.data(), window.size(), simulator);
+
+   if(tracing) {
+      trace_writer.close();
+   }
+
+   setAglaisLogLevel(log_level);
+
+   return result;
+}
+
+AglaisDivergence findAglaisDivergenceInFile(const char *path,
+                                            Simulator &simulator,
+                                            const AglaisDivergenceOptions &options)
+{
+   MappedFile file{path};
+
+   return findAglaisDivergence(file.getData(), file.getSize(), simulator, options);
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,123 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+namespace kaleidoscope {
+namespace simulator {
+
+class Simulator;
+
+/// @brief Parameters of the search for the first divergence of a replay.
+///
+struct AglaisDivergenceOptions {
+
+   /// @brief The number of cycles between two firmware checkpoints.
+   /// @details This is the max. number of cycles that are replayed
+   ///        again once a divergence is found.
+   ///
+   uint32_t checkpoint_interval = 10000;
+
+   /// @brief The path of a Chrome trace file that the replay of the
+   ///        diverging window is traced to.
+   /// @details No trace is written if this is nullptr.
+   ///        See TraceWriter.
+   ///
+   const char *trace_path = nullptr;
+};
+
+/// @brief The first cycle of a replay whose HID reports differ
+///        from the recording.
+///
+struct AglaisDivergence {
+
+   /// @brief True if the replay diverged.
+   ///
+   bool found = false;
+
+   /// @brief The id of the diverging cycle.
+   ///
+   uint32_t cycle_id = 0;
+
+   /// @brief The start time [ms] of the diverging cycle.
+   ///
+   uint32_t time = 0;
+
+   /// @brief The id of the first cycle that was replayed again
+   ///        from the last checkpoint.
+   ///
+   uint32_t checkpoint_cycle_id = 0;
+
+   /// @brief The key actions of the diverging cycle as
+   ///        Aglais commands, one per line.
+   ///
+   std::string input_events;
+
+   /// @brief The differences between the expected and the emitted
+   ///        reports, one per line.
+   ///
+   std::string report_diff;
+
+   /// @brief The number of cycles replayed up to and including
+   ///        the diverging cycle or to the end of the document.
+   ///
+   uint64_t n_cycles = 0;
+};
+
+/// @brief Replays an Aglais document until its first divergence.
+/// @details During the replay, the firmware state is checkpointed
+///        at regular intervals (see FirmwareSnapshot). The replay
+///        runs quietly and stops at the first cycle whose reports
+///        differ from the recording. The firmware is then reset
+///        to the last checkpoint and the window up to the diverging
+///        cycle is replayed once more with full Aglais logging
+///        and optional tracing.
+///
+///        Afterwards, the firmware is left in the state after
+///        the diverging cycle.
+///
+/// @param data The document.
+/// @param size The size of the document in bytes.
+/// @param simulator The simulator to replay the document with.
+/// @param options Parameters of the search.
+/// @returns The first divergence.
+///
+AglaisDivergence findAglaisDivergence(const char *data, size_t size,
+                                      Simulator &simulator,
+                                      const AglaisDivergenceOptions &options
+                                          = AglaisDivergenceOptions{});
+
+/// @brief Replays an Aglais document that is stored in a file
+///        until its first divergence.
+/// @details See findAglaisDivergence(...) for details.
+/// @param path The path of the file.
+/// @param simulator The simulator to replay the document with.
+/// @param options Parameters of the search.
+/// @returns The first divergence.
+///
+AglaisDivergence findAglaisDivergenceInFile(const char *path,
+                                            Simulator &simulator,
+                                            const AglaisDivergenceOptions &options
+                                                = AglaisDivergenceOptions{});
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -16,19 +16,65 @@
  */
 
 #include "kaleidoscope_simulator/AglaisInterface.h"
-#include "kaleidoscope_simulator/reports/KeyboardReport.h"
-#include "kaleidoscope_simulator/reports/BootKeyboardReport.h"
-#include "kaleidoscope_simulator/reports/MouseReport.h"
-#include "kaleidoscope_simulator/reports/AbsoluteMouseReport.h"
+#include "kaleidoscope_simulator/reports/HIDReport.h"
+#include "kaleidoscope_simulator/SimulatorCore.h"
+#include "kaleidoscope_simulator/Simulator.h"
+#include "kaleidoscope_simulator/ExpectedReportStream.h"
+#include "kaleidoscope_simulator/AglaisCycleStatistics.h"
+#include "kaleidoscope_simulator/AglaisStreamParser.h"
+#include "kaleidoscope_simulator/MappedFile.h"
+#include "kaleidoscope_simulator/AglaisBinaryParser.h"
+#include "kaleidoscope_simulator/AglaisWriter.h"
 #include "Aglais.h"
 #include "aglais/Consumer_.h"
 #include "papilio/actions/generic_report/AssertReportEquals.h"
 #include "papilio/Simulator.h"
 #include "HID-Settings.h"
 
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+
 namespace kaleidoscope {
 namespace simulator {
    
+namespace {
+   
+thread_local AglaisLogLevel log_level = AglaisLogLevel::reactions;
+thread_local AglaisCycleStatistics *cycle_statistics = nullptr;
+
+// Reports with these ids are ignored by the simulator.
+//
+bool isIgnoredReport(uint8_t id)
+{
+   switch(id) {
+      // TODO: React appropriately on the following
+      //
+      case HID_REPORTID_GAMEPAD:
+      case HID_REPORTID_CONSUMERCONTROL:
+      case HID_REPORTID_SYSTEMCONTROL:
+         return true;
+   }
+   return false;
+}
+
+// Queues an assertion that the next report equals a given report.
+//
+struct ReportAssertionQueuer
+{
+   papilio::Simulator &simulator;
+   
+   template<typename _ReportType>
+   void operator()(const _ReportType &report) const {
+      simulator.reportActionsQueue().queue(
+         papilio::actions::AssertReportEquals<_ReportType>{&report.getReportData()}
+      );
+   }
+};
+
+} // namespace
+   
 /// @private
 ///
 class SimulatorConsumerAdaptor : public aglais::Consumer_
@@ -36,11 +82,55 @@ class SimulatorConsumerAdaptor : public aglais::Consumer_
    public:
       
       SimulatorConsumerAdaptor(papilio::Simulator &simulator)
-         :  simulator_(simulator)
-      {}
+         :  simulator_(simulator),
+            log_level_(getAglaisLogLevel()),
+            cycle_statistics_(cycle_statistics)
+      {
+         // The Kaleidoscope specific core knows about reports emitted
+         // during a cycle.
+         //
+         core_ = dynamic_cast<const SimulatorCore*>(&simulator_.getCore());
+         
+         // A Kaleidoscope simulator passes every emitted report to a hook.
+         // Reports are then verified against the stream of expected 
+         // reports as they are emitted, without any report actions
+         // being queued.
+         //
+         auto active = Simulator::getActive();
+         if(core_ && active && (&active->getSimulatorCore() == core_)) {
+            
+            ks_simulator_ = active;
+            previous_hook_ = ks_simulator_->getHIDReportHook();
+            
+            ks_simulator_->setHIDReportHook(
+               [this](uint8_t id, const uint8_t *data, int length) {
+                  if(previous_hook_) { previous_hook_(id, data, length); }
+                  this->verifyReport(id, data, length);
+               }
+            );
+            
+            simulator_.setErrorIfReportWithoutQueuedActions(false);
+            
+            if(cycle_statistics_) {
+               ks_simulator_->getSimulatorCore().setTrackLEDChanges(true);
+            }
+         }
+      }
+      
+      ~SimulatorConsumerAdaptor() {
+         if(ks_simulator_) {
+            ks_simulator_->setHIDReportHook(std::move(previous_hook_));
+            
+            if(cycle_statistics_) {
+               ks_simulator_->getSimulatorCore().setTrackLEDChanges(false);
+            }
+         }
+      }
       
       virtual void onFirmwareId(const char *firmware_id) override {
-         simulator_.log() << "Aglais: firmware_id " << firmware_id;
+         if(this->isLogged(AglaisLogLevel::actions)) {
+            simulator_.log() << "Aglais: firmware_id " << firmware_id;
+         }
          // TODO: Use this method to verify that the firmware that was used
          //       to generate the Aglais-script that is currently 
          //       parsed matches the firmware running in the simulator.
@@ -48,6 +138,9 @@ class SimulatorConsumerAdaptor : public aglais::Consumer_
       
       virtual void onStartCycle(uint32_t cycle_id, uint32_t cycle_start_time) override {
          //simulator_.log() << "Aglais: start_cycle " << cycle_id << ' ' << cycle_start_time;
+         cycle_id_ = cycle_id;
+         cycle_time_ = cycle_start_time;
+         cycle_active_ = false;
          simulator_.setTime(cycle_start_time);
       }
       virtual void onEndCycle(uint32_t cycle_id, uint32_t cycle_end_time) override {
@@ -55,22 +148,32 @@ class SimulatorConsumerAdaptor : public aglais::Consumer_
          
          simulator_.cycle(true /*suppress cycle log info*/);
          
-         if(!simulator_.reportActionsQueue().empty()) {
-            simulator_.error() << "Report actions are left in queue";
+         this->checkAllReportsEmitted();
+         
+         if(cycle_statistics_) {
+            this->addCycleStatistics(cycle_end_time - cycle_time_);
          }
          
          simulator_.setTime(cycle_end_time);
       }
       virtual void onKeyPressed(uint8_t row, uint8_t col) override {
-         simulator_.log() << "Aglais: action key_pressed " << (int)row << ' ' << (int)col;
+         cycle_active_ = true;
+         if(this->isLogged(AglaisLogLevel::actions)) {
+            simulator_.log() << "Aglais: action key_pressed " << (int)row << ' ' << (int)col;
+         }
          simulator_.pressKey(row, col);
       }
       virtual void onKeyReleased(uint8_t row, uint8_t col) override {
-         simulator_.log() << "Aglais: action key_released " << (int)row << ' ' << (int)col;
+         cycle_active_ = true;
+         if(this->isLogged(AglaisLogLevel::actions)) {
+            simulator_.log() << "Aglais: action key_released " << (int)row << ' ' << (int)col;
+         }
          simulator_.releaseKey(row, col);
       }
       virtual void onHIDReport(uint8_t id, int length, const uint8_t *data) override {
-         {
+         cycle_active_ = true;
+         
+         if(this->isLogged(AglaisLogLevel::reactions)) {
             auto log = simulator_.log();
             
             log << "Aglais: reaction hid_report " << (int)id << ' ' << (int)length << ' ';
@@ -78,79 +181,270 @@ class SimulatorConsumerAdaptor : public aglais::Consumer_
                log << (int)data[i] << ' ';
             }
          }
-            
-         switch(id) {
-            // TODO: React appropriately on the following
-            //
-            case HID_REPORTID_GAMEPAD:
-            case HID_REPORTID_CONSUMERCONTROL:
-            case HID_REPORTID_SYSTEMCONTROL:
+         
+         if(isIgnoredReport(id)) {
+            if(this->isLogged(AglaisLogLevel::reactions)) {
                simulator_.log() << "***Ignoring hid report with id = " << id;
-               break;
-            case HID_REPORTID_KEYBOARD:
-               {
-                  assert(length == sizeof(BootKeyboardReport::ReportDataType));
-                  simulator_.reportActionsQueue().queue(
-                     papilio::actions::AssertReportEquals<BootKeyboardReport>{data}
-                  );
-               }
-               break;
-            case HID_REPORTID_MOUSE_ABSOLUTE:
-               {
-                  assert(length == sizeof(AbsoluteMouseReport::ReportDataType));
-                  simulator_.reportActionsQueue().queue(
-                     papilio::actions::AssertReportEquals<AbsoluteMouseReport>{data}
-                  );
-               }
-               break;
-            case HID_REPORTID_MOUSE:
-               {
-                  assert(length == sizeof(MouseReport::ReportDataType));
-                  simulator_.reportActionsQueue().queue(
-                     papilio::actions::AssertReportEquals<MouseReport>{data}
-                  );
-               }
-               break;
-            case HID_REPORTID_NKRO_KEYBOARD:
-               {
-                  assert(length == sizeof(KeyboardReport::ReportDataType));
-                  simulator_.reportActionsQueue().queue(
-                     papilio::actions::AssertReportEquals<KeyboardReport>{data}
-                  );
-               }
-               break;
-            default:
-               simulator_.error() << "Aglais encountered unknown HID report with id = " << id;
+            }
+            return;
+         }
+         
+         if(ks_simulator_) {
+            this->expectReport(id, length, data);
+            return;
+         }
+            
+         auto type = HIDReport::typeFromId(id);
+         
+         if(type == HIDReportType::none) {
+            ++n_errors_;
+            simulator_.error() << "Aglais encountered unknown HID report with id = " << id;
+            return;
          }
+         
+         assert(size_t(length) == HIDReport::getDataSize(type));
+         
+         HIDReport{id, data}.visit(ReportAssertionQueuer{simulator_});
       }
       virtual void onSetTime(uint32_t time) override {
-         simulator_.log() << "Aglais: set_time " << time;
+         if(this->isLogged(AglaisLogLevel::actions)) {
+            simulator_.log() << "Aglais: set_time " << time;
+         }
          simulator_.setTime(time);
       }
-      virtual void onCycle(uint32_t cycle_id, uint32_t cycle_start_time, uint32_t cycle_end_time) {
-         this->onStartCycle(cycle_id, cycle_start_time);
-         this->onEndCycle(cycle_id, cycle_end_time);
-      }
       virtual void onCycles(uint32_t start_cycle_id, uint32_t start_time_id, 
                                const std::vector<uint32_t> &cycle_durations) override {
-         auto cycle_start_time = start_time_id;
+         
+         // Runs of cycles come without any expected reactions. Thus, 
+         // the expected reports are checked only once for the entire run.
+         //
+         this->checkAllReportsEmitted();
+         
+         // The end time of a cycle is the start time of the next one.
+         //
+         auto cycle_time = start_time_id;
          auto cycle_id = start_cycle_id;
+         
+         cycle_active_ = false;
+         
          for(const auto duration: cycle_durations) {
-            auto cycle_end_time = cycle_start_time + duration;
-            this->onCycle(cycle_id, cycle_start_time, cycle_end_time);
+            
+            cycle_id_ = cycle_id;
+            cycle_time_ = cycle_time;
+            
+            simulator_.setTime(cycle_time);
+            simulator_.cycle(true /*suppress cycle log info*/);
+            
+            // Reports that are verified by the hook are already 
+            // reported as unexpected.
+            //
+            if(!ks_simulator_ && core_ && core_->wasLoopRun() 
+                  && (core_->getNumReportsInLoop() != 0)) {
+               ++n_errors_;
+               simulator_.error() << "Aglais: Unexpected HID report in cycle " 
+                  << cycle_id << " (time " << cycle_time 
+                  << ") of a run of cycles without reactions";
+            }
+            
+            if(cycle_statistics_) {
+               this->addCycleStatistics(duration);
+            }
+            
             ++cycle_id;
-            cycle_start_time = cycle_end_time;
+            cycle_time += duration;
+         }
+         
+         simulator_.setTime(cycle_time);
+      }
+      
+      size_t getNumErrors() const { return n_errors_; }
+      
+   private:
+      
+      void expectReport(uint8_t id, int length, const uint8_t *data) {
+         
+         auto type = HIDReport::typeFromId(id);
+         
+         if(type == HIDReportType::none) {
+            ++n_errors_;
+            simulator_.error() << "Aglais encountered unknown HID report with id = " << id;
+            return;
+         }
+         
+         assert(size_t(length) == HIDReport::getDataSize(type));
+         
+         expected_reports_.push(id, length, data);
+      }
+      
+      void verifyReport(uint8_t id, const uint8_t *data, int length) {
+         
+         if(isIgnoredReport(id)) { return; }
+         
+         if(!expected_reports_.verify(id, data, length, difference_)) {
+            ++n_errors_;
+            simulator_.error() << "Aglais: HID report in cycle " << cycle_id_ 
+               << " (time " << cycle_time_ << ") " << difference_;
+         }
+      }
+      
+      void addCycleStatistics(uint32_t duration) {
+         
+         auto activity = CycleActivity::idle;
+         
+         if(cycle_active_) {
+            activity = CycleActivity::key_events;
+         }
+         else if(ks_simulator_ && core_->haveLEDsChanged()) {
+            activity = CycleActivity::led_effect;
          }
+         
+         cycle_statistics_->addCycle(duration, activity);
+      }
+      
+      void checkAllReportsEmitted() {
+         if(!expected_reports_.empty()) {
+            ++n_errors_;
+            simulator_.error() << "Aglais: " << expected_reports_.getNumPending() 
+               << " expected HID report(s) not emitted in cycle " << cycle_id_
+               << " (time " << cycle_time_ << ")";
+            expected_reports_.clear();
+         }
+         if(!simulator_.reportActionsQueue().empty()) {
+            ++n_errors_;
+            simulator_.error() << "Report actions are left in queue";
+         }
+      }
+      
+      // Compiles to false if logging is disabled at compile time. 
+      // The log statements are then removed entirely. Nothing is 
+      // formatted while the simulator is quiet.
+      //
+      bool isLogged(AglaisLogLevel level) const {
+         return KALEIDOSCOPE_SIMULATOR_AGLAIS_LOGGING 
+                  && (int(log_level_) >= int(level))
+                  && !simulator_.getQuiet();
       }
       
    private:
       
       papilio::Simulator &simulator_;
+      const SimulatorCore *core_ = nullptr;
+      AglaisLogLevel log_level_;
+      
+      Simulator *ks_simulator_ = nullptr;
+      Simulator::HIDReportHook previous_hook_;
+      ExpectedReportStream expected_reports_;
+      std::string difference_;
+      
+      uint32_t cycle_id_ = 0;
+      uint32_t cycle_time_ = 0;
+      bool cycle_active_ = false;
+      
+      AglaisCycleStatistics *cycle_statistics_ = nullptr;
       
+      size_t n_errors_ = 0;
 };
 
-void processAglaisDocument(const char *code, papilio::Simulator &simulator)
+namespace {
+   
+constexpr size_t buffer_size = 64*1024;
+constexpr size_t max_cycles_per_batch = 4096;
+
+// Parses an uncompressed document of either format that resides 
+// in memory.
+//
+void parseAglaisMemory(const char *data, size_t size, 
+                       aglais::Consumer_ &consumer)
+{
+   if(aglais_binary::isBinary(data, size)) {
+      AglaisBinaryParser{consumer, buffer_size, max_cycles_per_batch}.parse(data, size);
+   }
+   else {
+      AglaisStreamParser{consumer, buffer_size, max_cycles_per_batch}.parse(data, size);
+   }
+}
+
+// Parses an uncompressed document of either format that is read 
+// from a source.
+//
+void parseAglaisSource(const AglaisStreamParser::Source &source, 
+                       aglais::Consumer_ &consumer,
+                       size_t cycles_per_batch = max_cycles_per_batch)
+{
+   // Read ahead the bytes that reveal the format. They are 
+   // passed on to the parser before any further input.
+   //
+   char prefix[sizeof(aglais_binary::magic)];
+   size_t n_prefix = 0;
+   
+   while(n_prefix < sizeof(prefix)) {
+      size_t n = source(prefix + n_prefix, sizeof(prefix) - n_prefix);
+      if(n == 0) { break; }
+      n_prefix += n;
+   }
+   
+   size_t prefix_pos = 0;
+   
+   AglaisStreamParser::Source prefixed_source 
+      = [&](char *buffer, size_t size) -> size_t {
+         if(prefix_pos < n_prefix) {
+            size_t n = std::min(size, n_prefix - prefix_pos);
+            memcpy(buffer, prefix + prefix_pos, n);
+            prefix_pos += n;
+            return n;
+         }
+         return source(buffer, size);
+      };
+   
+   if(aglais_binary::isBinary(prefix, n_prefix)) {
+      AglaisBinaryParser{consumer, buffer_size, cycles_per_batch}.parse(prefixed_source);
+   }
+   else {
+      AglaisStreamParser{consumer, buffer_size, cycles_per_batch}.parse(prefixed_source);
+   }
+}
+
+template<typename _Func>
+size_t replay(papilio::Simulator &simulator, _Func parse)
+{
+   auto rwqa_state = simulator.getErrorIfReportWithoutQueuedActions();
+   
+   SimulatorConsumerAdaptor sca(simulator);
+   parse(sca);
+   
+   simulator.setErrorIfReportWithoutQueuedActions(rwqa_state);
+   
+   return sca.getNumErrors();
+}
+
+} // namespace
+
+void setAglaisLogLevel(AglaisLogLevel level)
+{
+   log_level = level;
+}
+
+AglaisLogLevel getAglaisLogLevel()
+{
+   return log_level;
+}
+
+void setAglaisCycleStatistics(AglaisCycleStatistics *statistics)
 {
+   cycle_statistics = statistics;
+}
+
+size_t processAglaisDocument(const char *code, papilio::Simulator &simulator)
+{
+   if(aglais_binary::isBinary(code, sizeof(aglais_binary::magic))) {
+      
+      // A binary document is parsed up to its end record.
+      //
+      return replay(simulator, [&](aglais::Consumer_ &consumer) {
+         AglaisBinaryParser{consumer, buffer_size, max_cycles_per_batch}.parse(code, SIZE_MAX);
+      });
+   }
+   
    auto rwqa_state = simulator.getErrorIfReportWithoutQueuedActions();
    
    aglais::Aglais a;
@@ -160,6 +454,65 @@ void processAglaisDocument(const char *code, papilio::Simulator &simulator)
    a.parse(code, sca);
    
    simulator.setErrorIfReportWithoutQueuedActions(rwqa_state);
+   
+   return sca.getNumErrors();
+}
+
+size_t processAglaisDocument(const char *data, size_t size, papilio::Simulator &simulator)
+{
+   return replay(simulator, [&](aglais::Consumer_ &consumer) {
+      parseAglaisMemory(data, size, consumer);
+   });
+}
+
+size_t processAglaisStream(std::istream &in, papilio::Simulator &simulator)
+{
+   return replay(simulator, [&](aglais::Consumer_ &consumer) {
+      parseAglaisSource(AglaisStreamParser::makeSource(in), consumer);
+   });
+}
+
+size_t processAglaisFileDescriptor(int fd, papilio::Simulator &simulator)
+{
+   return replay(simulator, [&](aglais::Consumer_ &consumer) {
+      parseAglaisSource(AglaisStreamParser::makeSource(fd), consumer);
+   });
+}
+
+size_t processAglaisFile(const char *path, papilio::Simulator &simulator)
+{
+   MappedFile file{path};
+   
+   return replay(simulator, [&](aglais::Consumer_ &consumer) {
+      parseAglaisMemory(file.getData(), file.getSize(), consumer);
+   });
+}
+
+void parseAglaisDocument(const char *data, size_t size, 
+                         aglais::Consumer_ &consumer)
+{
+   parseAglaisMemory(data, size, consumer);
+}
+
+void convertAglaisDocument(std::istream &in, std::ostream &out, 
+                           AglaisFormat format)
+{
+   std::unique_ptr<AglaisWriter_> writer;
+   
+   if(format == AglaisFormat::binary) {
+      writer.reset(new AglaisBinaryWriter{out});
+   }
+   else {
+      writer.reset(new AglaisTextWriter{out});
+   }
+   
+   // Runs of cycles are not split into batches. Otherwise, every batch
+   // would be written as a run of its own and a round trip would
+   // not reproduce the original document.
+   //
+   parseAglaisSource(AglaisStreamParser::makeSource(in), *writer, SIZE_MAX);
+   
+   writer->finish();
 }
 
 } // namespace simulator
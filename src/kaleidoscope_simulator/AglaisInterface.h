@@ -17,14 +17,159 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <istream>
+#include <ostream>
+
+/// @brief Set this macro to zero to remove the log output of 
+///        Aglais replays at compile time.
+///
+#ifndef KALEIDOSCOPE_SIMULATOR_AGLAIS_LOGGING
+#define KALEIDOSCOPE_SIMULATOR_AGLAIS_LOGGING 1
+#endif
+
 namespace papilio {
 class Simulator;
 } // namespace papilio
 
+namespace aglais {
+class Consumer_;
+} // namespace aglais
+
 namespace kaleidoscope {
 namespace simulator {
 
-void processAglaisDocument(const char *code, papilio::Simulator &sim);
+/// @brief The encodings of Aglais documents.
+///
+enum class AglaisFormat {
+   text,
+   binary
+};
+
+/// @brief The verbosity levels of the log output of Aglais replays.
+///
+enum class AglaisLogLevel {
+   none,       ///< Nothing is logged.
+   actions,    ///< Key actions and changes of time are logged.
+   reactions   ///< Additionally, every expected HID report is logged
+               ///< with its payload.
+};
+
+/// @brief Sets the verbosity of the log output of Aglais replays.
+/// @details The level applies to all replays that are started by 
+///        the calling thread. It is checked before any log output is
+///        formatted. Thus, disabled output does not cost anything. 
+///        The default level is AglaisLogLevel::reactions.
+///        Nothing is logged while the simulator is quiet, regardless 
+///        of the level.
+/// @param level The new log level.
+///
+void setAglaisLogLevel(AglaisLogLevel level);
+
+/// @brief Retreives the verbosity of the log output of Aglais replays
+///        that are started by the calling thread.
+///
+AglaisLogLevel getAglaisLogLevel();
+
+class AglaisCycleStatistics;
+
+/// @brief Enables aggregation of the recorded cycle durations 
+///        during Aglais replays.
+/// @details Applies to all replays that are started by the calling thread
+///        through the processAglais... functions. Parallel replays 
+///        (see processAglaisDocumentParallel(...)) and divergence 
+///        searches (see findAglaisDivergence(...)) do not aggregate 
+///        statistics.
+///        While replaying with a Kaleidoscope simulator, cycles
+///        during which only the LEDs changed are told apart
+///        from idle cycles.
+/// @param statistics The object that aggregates the durations or
+///        nullptr to disable aggregation.
+///
+void setAglaisCycleStatistics(AglaisCycleStatistics *statistics);
+
+/// @brief Replays an Aglais document.
+/// @details Binary documents are detected automatically. They must
+///        be complete, i.e. terminated by an end record.
+/// @param code The document.
+/// @param sim The simulator to replay the document with.
+/// @returns The number of deviations from the document that the 
+///        replay detected. Failures of report actions that are 
+///        checked by the simulator's report queue are not included.
+///
+size_t processAglaisDocument(const char *code, papilio::Simulator &sim);
+
+/// @brief Replays an Aglais document of known size.
+/// @details Binary documents are detected automatically. Text documents
+///        must be uncompressed.
+/// @param data The document.
+/// @param size The size of the document in bytes.
+/// @param sim The simulator to replay the document with.
+/// @returns The number of deviations from the document that the
+///        replay detected.
+///
+size_t processAglaisDocument(const char *data, size_t size, papilio::Simulator &sim);
+
+/// @brief Replays an Aglais document that is read from a stream.
+/// @details The document is parsed incrementally with constant 
+///        memory consumption, regardless of its size.
+///        Binary documents are detected automatically. Text
+///        documents must be uncompressed.
+/// @param in The stream to read from.
+/// @param sim The simulator to replay the document with.
+/// @returns The number of deviations from the document that the
+///        replay detected.
+///
+size_t processAglaisStream(std::istream &in, papilio::Simulator &sim);
+
+/// @brief Replays an Aglais document that is read from a file descriptor.
+/// @details See processAglaisStream(...).
+/// @param fd The file descriptor to read from, e.g. a pipe or a file.
+/// @param sim The simulator to replay the document with.
+/// @returns The number of deviations from the document that the
+///        replay detected.
+///
+size_t processAglaisFileDescriptor(int fd, papilio::Simulator &sim);
+
+/// @brief Replays an Aglais document that is stored in a file.
+/// @details The file is mapped into memory read-only and parsed in 
+///        place. Thus, recordings can be replayed without 
+///        being compiled into the simulator binary. Startup time
+///        does not depend on the size of the recording.
+///        Binary documents are detected automatically. Text
+///        documents must be uncompressed.
+/// @param path The path of the file.
+/// @param sim The simulator to replay the document with.
+/// @returns The number of deviations from the document that the
+///        replay detected.
+///
+size_t processAglaisFile(const char *path, papilio::Simulator &sim);
+
+/// @brief Parses an Aglais document of known size without replaying it.
+/// @details Binary documents are detected automatically. Text documents
+///        must be uncompressed. Use this to analyze recordings.
+/// @param data The document.
+/// @param size The size of the document in bytes.
+/// @param consumer The consumer that receives the document's events.
+///
+void parseAglaisDocument(const char *data, size_t size, 
+                         aglais::Consumer_ &consumer);
+
+/// @brief Converts an Aglais document between text and binary format.
+/// @details The format of the input is detected automatically. 
+///        The conversion is lossless. Converting a text 
+///        document to binary and back reproduces the original 
+///        text if it was formatted the way Kaleidoscope's Aglais
+///        recorder formats documents.
+///        Except for runs of cycles, which are converted as a whole,
+///        the input is processed incrementally. The memory used 
+///        thus grows with the length of the longest run.
+/// @param in The stream to read the document from.
+/// @param out The stream to write the converted document to.
+/// @param format The format of the output document.
+///
+void convertAglaisDocument(std::istream &in, std::ostream &out, 
+                           AglaisFormat format);
 
 } // namespace simulator
 } // namespace kaleidoscope
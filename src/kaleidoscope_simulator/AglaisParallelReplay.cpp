@@ -0,0 +1,560 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/AglaisParallelReplay.h"
+#include "kaleidoscope_simulator/AglaisInterface.h"
+#include "kaleidoscope_simulator/Simulator.h"
+#include "kaleidoscope_simulator/SimulatorCore.h"
+#include "kaleidoscope_simulator/KeyMatrix.h"
+#include "kaleidoscope_simulator/MappedFile.h"
+#include "kaleidoscope_simulator/WorkerPool.h"
+#include "kaleidoscope_simulator/ExpectedReportStream.h"
+#include "kaleidoscope_simulator/FirmwareSnapshot.h"
+#include "aglais/Consumer_.h"
+
+#include <sstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace kaleidoscope {
+namespace simulator {
+
+namespace {
+
+// A point of the document at which a segment starts. Cycles are
+// counted by their position in the document as cycle ids
+// are not necessarily contiguous.
+//
+struct Boundary {
+   uint64_t cycle_pos;
+   uint32_t time;
+};
+
+// Finds the safe boundaries of a document. Nothing is simulated.
+//
+class BoundaryScanner : public aglais::Consumer_
+{
+   public:
+
+      BoundaryScanner(const ParallelReplayOptions &options)
+         :  options_(options)
+      {}
+
+      virtual void onFirmwareId(const char *firmware_id) override {}
+
+      virtual void onStartCycle(uint32_t cycle_id, uint32_t cycle_start_time) override {
+         this->checkBoundary(cycle_start_time);
+      }
+      virtual void onEndCycle(uint32_t cycle_id, uint32_t cycle_end_time) override {
+         ++cycle_pos_;
+      }
+      virtual void onKeyPressed(uint8_t row, uint8_t col) override {
+         held_keys_.set(row, col, true);
+         last_activity_pos_ = cycle_pos_;
+         active_ = true;
+      }
+      virtual void onKeyReleased(uint8_t row, uint8_t col) override {
+         held_keys_.set(row, col, false);
+         last_activity_pos_ = cycle_pos_;
+         active_ = true;
+      }
+      virtual void onHIDReport(uint8_t id, int length, const uint8_t *data) override {
+         last_activity_pos_ = cycle_pos_;
+         active_ = true;
+      }
+      virtual void onSetTime(uint32_t time) override {}
+
+      virtual void onCycles(uint32_t start_cycle_id, uint32_t start_time_id,
+                               const std::vector<uint32_t> &cycle_durations) override {
+         auto cycle_time = start_time_id;
+         for(const auto duration: cycle_durations) {
+            this->checkBoundary(cycle_time);
+            ++cycle_pos_;
+            cycle_time += duration;
+         }
+      }
+
+      const std::vector<Boundary> &getBoundaries() const { return boundaries_; }
+
+      uint64_t getNumCycles() const { return cycle_pos_; }
+
+   private:
+
+      void checkBoundary(uint32_t cycle_start_time) {
+
+         // The time of the last activity is only known once the
+         // cycle it happened in has ended.
+         //
+         if(active_ && (last_activity_pos_ < cycle_pos_)) {
+            last_activity_time_ = cycle_start_time;
+            active_ = false;
+         }
+
+         if(active_ || held_keys_.any()) { return; }
+
+         if(cycle_start_time - last_activity_time_ < options_.min_idle_time) {
+            return;
+         }
+
+         uint64_t segment_start = boundaries_.empty() ? 0 : boundaries_.back().cycle_pos;
+         if(cycle_pos_ - segment_start < options_.min_segment_cycles) {
+            return;
+         }
+
+         boundaries_.push_back(Boundary{cycle_pos_, cycle_start_time});
+      }
+
+   private:
+
+      const ParallelReplayOptions &options_;
+
+      KeyMatrix held_keys_;
+      uint64_t cycle_pos_ = 0;
+      uint64_t last_activity_pos_ = 0;
+      uint32_t last_activity_time_ = 0;
+      bool active_ = false;
+
+      std::vector<Boundary> boundaries_;
+};
+
+// Thrown to stop parsing once the end of a segment is reached.
+//
+struct EndOfSegment {};
+
+// Replays a document up to its last boundary and captures the firmware 
+// state at every boundary. Only the firmware is run. HID reports are
+// neither processed nor verified.
+//
+class BoundaryCapturer : public aglais::Consumer_
+{
+   public:
+
+      BoundaryCapturer(SimulatorCore &core, const std::vector<Boundary> &boundaries,
+                       std::vector<FirmwareSnapshot> &snapshots)
+         :  core_(core),
+            boundaries_(boundaries),
+            snapshots_(snapshots)
+      {
+         snapshots_.resize(boundaries_.size());
+      }
+
+      virtual void onFirmwareId(const char *firmware_id) override {}
+
+      virtual void onStartCycle(uint32_t cycle_id, uint32_t cycle_start_time) override {
+         this->checkBoundary();
+         core_.setTime(cycle_start_time);
+      }
+      virtual void onEndCycle(uint32_t cycle_id, uint32_t cycle_end_time) override {
+         core_.loop();
+         core_.setTime(cycle_end_time);
+         ++cycle_pos_;
+      }
+      virtual void onKeyPressed(uint8_t row, uint8_t col) override {
+         core_.pressKey(row, col);
+      }
+      virtual void onKeyReleased(uint8_t row, uint8_t col) override {
+         core_.releaseKey(row, col);
+      }
+      virtual void onHIDReport(uint8_t id, int length, const uint8_t *data) override {}
+      virtual void onSetTime(uint32_t time) override {
+         core_.setTime(time);
+      }
+      virtual void onCycles(uint32_t start_cycle_id, uint32_t start_time_id,
+                               const std::vector<uint32_t> &cycle_durations) override {
+         auto cycle_time = start_time_id;
+         for(const auto duration: cycle_durations) {
+            this->checkBoundary();
+            core_.setTime(cycle_time);
+            core_.loop();
+            ++cycle_pos_;
+            cycle_time += duration;
+         }
+         core_.setTime(cycle_time);
+      }
+
+   private:
+
+      void checkBoundary() {
+
+         if(cycle_pos_ != boundaries_[next_].cycle_pos) { return; }
+
+         core_.takeSnapshot(snapshots_[next_]);
+         ++next_;
+
+         // Nothing beyond the last boundary is needed.
+         //
+         if(next_ == boundaries_.size()) { throw EndOfSegment{}; }
+      }
+
+   private:
+
+      SimulatorCore &core_;
+      const std::vector<Boundary> &boundaries_;
+      std::vector<FirmwareSnapshot> &snapshots_;
+
+      uint64_t cycle_pos_ = 0;
+      size_t next_ = 0;
+};
+
+// Replays the cycles [begin_pos, end_pos) of a document and verifies the
+// emitted reports against the recorded ones.
+//
+class SegmentReplayer : public aglais::Consumer_
+{
+   public:
+
+      SegmentReplayer(Simulator &simulator, uint64_t begin_pos, uint64_t end_pos,
+                      size_t max_messages)
+         :  simulator_(simulator),
+            core_(simulator.getSimulatorCore()),
+            begin_pos_(begin_pos),
+            end_pos_(end_pos),
+            max_messages_(max_messages),
+            previous_hook_(simulator.getHIDReportHook())
+      {
+         simulator_.setHIDReportHook(
+            [this](uint8_t id, const uint8_t *data, int length) {
+               if(previous_hook_) { previous_hook_(id, data, length); }
+               emitted_.push(id, length, data);
+            }
+         );
+      }
+
+      ~SegmentReplayer() {
+         simulator_.setHIDReportHook(std::move(previous_hook_));
+      }
+
+      virtual void onFirmwareId(const char *firmware_id) override {}
+
+      virtual void onStartCycle(uint32_t cycle_id, uint32_t cycle_start_time) override {
+         if(cycle_pos_ >= end_pos_) { throw EndOfSegment{}; }
+         if(!this->isActive()) { return; }
+
+         expected_.clear();
+         simulator_.setTime(cycle_start_time);
+      }
+      virtual void onEndCycle(uint32_t cycle_id, uint32_t cycle_end_time) override {
+         if(this->isActive()) {
+            emitted_.clear();
+            simulator_.cycle(true /*suppress cycle log info*/);
+            this->verifyCycle(cycle_id, core_.getTime());
+            simulator_.setTime(cycle_end_time);
+         }
+         ++cycle_pos_;
+      }
+      virtual void onKeyPressed(uint8_t row, uint8_t col) override {
+         if(!this->isActive()) { return; }
+         simulator_.pressKey(row, col);
+      }
+      virtual void onKeyReleased(uint8_t row, uint8_t col) override {
+         if(!this->isActive()) { return; }
+         simulator_.releaseKey(row, col);
+      }
+      virtual void onHIDReport(uint8_t id, int length, const uint8_t *data) override {
+         if(!this->isActive()) { return; }
+         expected_.push(id, length, data);
+      }
+      virtual void onSetTime(uint32_t time) override {
+         if(!this->isActive()) { return; }
+         simulator_.setTime(time);
+      }
+      virtual void onCycles(uint32_t start_cycle_id, uint32_t start_time_id,
+                               const std::vector<uint32_t> &cycle_durations) override {
+
+         // Skip what precedes the segment without simulating it.
+         //
+         size_t first = 0;
+         if(cycle_pos_ < begin_pos_) {
+            uint64_t n_skip = begin_pos_ - cycle_pos_;
+            if(n_skip >= cycle_durations.size()) {
+               cycle_pos_ += cycle_durations.size();
+               return;
+            }
+            first = n_skip;
+            cycle_pos_ += n_skip;
+         }
+
+         expected_.clear();
+
+         auto cycle_time = start_time_id;
+         for(size_t i = 0; i < first; ++i) {
+            cycle_time += cycle_durations[i];
+         }
+
+         for(size_t i = first; i < cycle_durations.size(); ++i) {
+
+            if(cycle_pos_ >= end_pos_) { throw EndOfSegment{}; }
+
+            emitted_.clear();
+            simulator_.setTime(cycle_time);
+            simulator_.cycle(true /*suppress cycle log info*/);
+            this->verifyCycle(start_cycle_id + i, cycle_time);
+
+            ++cycle_pos_;
+            cycle_time += cycle_durations[i];
+         }
+
+         simulator_.setTime(cycle_time);
+      }
+
+      size_t getNumErrors() const { return n_errors_; }
+
+      const std::string &getMessages() const { return messages_; }
+
+   private:
+
+      bool isActive() const {
+         return (cycle_pos_ >= begin_pos_) && (cycle_pos_ < end_pos_);
+      }
+
+      void verifyCycle(uint32_t cycle_id, uint32_t time) {
+
+         differences_.clear();
+         expected_.verifyCycle(emitted_, differences_);
+
+         for(const auto &difference: differences_) {
+            this->addError(cycle_id, time, difference);
+         }
+      }
+
+      void addError(uint32_t cycle_id, uint32_t time, const std::string &what) {
+
+         ++n_errors_;
+
+         // Excess errors are only counted.
+         //
+         if(n_errors_ > max_messages_) { return; }
+
+         messages_ += "Aglais: Cycle " + std::to_string(cycle_id) 
+                    + " (time " + std::to_string(time) + "): " + what + '\n';
+      }
+
+   private:
+
+      Simulator &simulator_;
+      const SimulatorCore &core_;
+
+      uint64_t begin_pos_;
+      uint64_t end_pos_;
+      uint64_t cycle_pos_ = 0;
+
+      ExpectedReportStream expected_;
+      ExpectedReportStream emitted_;
+      std::vector<std::string> differences_;
+
+      size_t max_messages_;
+      size_t n_errors_ = 0;
+      std::string messages_;
+
+      Simulator::HIDReportHook previous_hook_;
+};
+
+// Prepares a worker process for a replay.
+//
+void prepareWorker(Simulator &simulator)
+{
+   // The trace and the recording belong to the calling process.
+   //
+   if(simulator.getTraceWriter().isOpen()) {
+      simulator.getTraceWriter().discard();
+   }
+   simulator.getSimulatorCore().setAglaisRecorder(nullptr);
+
+   simulator.setQuiet();
+   simulator.setErrorIfReportWithoutQueuedActions(false);
+}
+
+// Replays a range of cycles. The result is the number of errors, 
+// followed by one error message per line.
+//
+std::string replaySegment(const char *data, size_t size, Simulator &simulator,
+                          uint64_t begin_pos, uint64_t end_pos,
+                          size_t max_messages)
+{
+   SegmentReplayer replayer{simulator, begin_pos, end_pos, max_messages};
+
+   try {
+      parseAglaisDocument(data, size, replayer);
+   }
+   catch(const EndOfSegment &) {}
+
+   return std::to_string(replayer.getNumErrors()) + '\n' + replayer.getMessages();
+}
+
+// Replays all segments of a document. Runs in a worker process.
+// The result has the format of the result of a single segment.
+//
+std::string replaySegments(const char *data, size_t size, Simulator &simulator,
+                           const std::vector<Boundary> &boundaries,
+                           const ParallelReplayOptions &options)
+{
+   prepareWorker(simulator);
+
+   // The firmware state at every boundary is determined by a serial 
+   // replay that does not verify any reports.
+   //
+   FirmwareSnapshot start_state;
+   std::vector<FirmwareSnapshot> snapshots;
+
+   if(!boundaries.empty()) {
+
+      simulator.takeSnapshot(start_state);
+
+      // The core is driven directly. With no context being active,
+      // the simulator does not process the firmware's reports.
+      //
+      Simulator::deactivate();
+
+      BoundaryCapturer capturer{simulator.getSimulatorCore(), boundaries, snapshots};
+
+      try {
+         parseAglaisDocument(data, size, capturer);
+      }
+      catch(const EndOfSegment &) {}
+
+      simulator.activate();
+   }
+
+   size_t n_segments = boundaries.size() + 1;
+
+   auto results = WorkerPool{options.max_workers}.run(n_segments, [&](size_t segment) {
+
+      // The pre-pass moved the firmware on to the last boundary.
+      //
+      uint64_t begin_pos = 0;
+      if(segment > 0) {
+         simulator.restoreSnapshot(snapshots[segment - 1]);
+         begin_pos = boundaries[segment - 1].cycle_pos;
+      }
+      else if(start_state.isValid()) {
+         simulator.restoreSnapshot(start_state);
+      }
+
+      // The last segment extends to the end of the document, including
+      // any commands that follow the last cycle.
+      //
+      uint64_t end_pos = (segment < boundaries.size()) 
+                              ? boundaries[segment].cycle_pos : UINT64_MAX;
+
+      return replaySegment(data, size, simulator, begin_pos, end_pos,
+                           options.max_messages_per_segment);
+   });
+
+   size_t n_errors = 0;
+   std::string messages;
+
+   for(size_t segment = 0; segment < n_segments; ++segment) {
+
+      const auto &result = results[segment];
+
+      if(!result.success) {
+         ++n_errors;
+         messages += "Aglais: Replay of segment " + std::to_string(segment) 
+                   + " failed: " + result.output + '\n';
+         continue;
+      }
+
+      std::istringstream in{result.output};
+
+      size_t n_segment_errors = 0;
+      in >> n_segment_errors;
+      in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+      n_errors += n_segment_errors;
+      messages.append(std::istreambuf_iterator<char>(in),
+                      std::istreambuf_iterator<char>());
+   }
+
+   return std::to_string(n_errors) + '\n' + messages;
+}
+
+// Reports the outcome of a worker through the calling simulator.
+//
+size_t reportResult(const WorkerPool::Result &result, Simulator &simulator)
+{
+   if(!result.success) {
+      simulator.error() << "Aglais: Parallel replay failed: " << result.output;
+      return 1;
+   }
+
+   std::istringstream in{result.output};
+
+   size_t n_errors = 0;
+   in >> n_errors;
+   in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+   std::string line;
+   size_t n_messages = 0;
+   while(std::getline(in, line)) {
+      simulator.error() << line;
+      ++n_messages;
+   }
+
+   if(n_errors > n_messages) {
+      simulator.error() << "Aglais: " << (n_errors - n_messages)
+         << " further error(s) in the parallel replay";
+   }
+
+   return n_errors;
+}
+
+} // namespace
+
+size_t processAglaisDocumentParallel(const char *data, size_t size,
+                                     Simulator &simulator,
+                                     const ParallelReplayOptions &options)
+{
+   BoundaryScanner scanner{options};
+   parseAglaisDocument(data, size, scanner);
+
+   // Without snapshots, the firmware state at the boundaries 
+   // can not be transferred.
+   //
+   std::vector<Boundary> boundaries;
+   if(FirmwareSnapshot::isSupported()) {
+      boundaries = scanner.getBoundaries();
+   }
+
+   simulator.log() << "Aglais: Replaying " << scanner.getNumCycles()
+      << " cycles in " << (boundaries.size() + 1) << " segment(s) with up to "
+      << WorkerPool{options.max_workers}.getMaxWorkers() << " worker(s)";
+
+   // The segments are replayed by a worker to leave the firmware 
+   // state of the calling process untouched.
+   //
+   auto result = WorkerPool{1}.run(1, [&](size_t) {
+      return replaySegments(data, size, simulator, boundaries, options);
+   });
+
+   return reportResult(result[0], simulator);
+}
+
+size_t processAglaisFileParallel(const char *path,
+                                 Simulator &simulator,
+                                 const ParallelReplayOptions &options)
+{
+   MappedFile file{path};
+
+   return processAglaisDocumentParallel(file.getData(), file.getSize(),
+                                        simulator, options);
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
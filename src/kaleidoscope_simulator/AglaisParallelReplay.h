@@ -0,0 +1,110 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace kaleidoscope {
+namespace simulator {
+   
+class Simulator;
+
+/// @brief Parameters of a parallel replay of an Aglais document.
+///
+struct ParallelReplayOptions {
+   
+   /// @brief The max. number of concurrent worker processes.
+   /// @details Zero selects the number of online processors.
+   ///
+   unsigned max_workers = 0;
+   
+   /// @brief The min. amount of time [ms] without key events and 
+   ///        reports that must precede a segment boundary.
+   ///
+   uint32_t min_idle_time = 5000;
+   
+   /// @brief The min. number of cycles of a segment.
+   ///
+   uint32_t min_segment_cycles = 50000;
+   
+   /// @brief The max. number of error messages reported per segment.
+   /// @details Errors beyond this number are still counted.
+   ///
+   size_t max_messages_per_segment = 100;
+};
+
+/// @brief Replays an Aglais document in segments that run concurrently.
+/// @details The document is split at safe boundaries. A boundary
+///        is safe if no key is held, all expected reports
+///        of previous cycles have been emitted and nothing
+///        happened for at least ParallelReplayOptions::min_idle_time.
+///
+///        The firmware state at every boundary is determined 
+///        by a serial pre-pass. It replays the document up to the 
+///        last boundary, running only the firmware. Reports 
+///        are neither processed nor verified. A FirmwareSnapshot 
+///        is captured at every boundary. Every segment is then 
+///        replayed by a worker process (see WorkerPool) that starts 
+///        from the snapshot taken at the segment's start. Thus,
+///        every segment starts from the exact state a serial replay 
+///        is in at that point.
+///
+///        The pre-pass is cheaper than a serial replay by the cost of 
+///        processing and verifying reports. The parallel replay
+///        therefore only pays off if that cost is significant.
+///        On platforms without firmware snapshots, the document is 
+///        replayed as a single segment.
+///
+///        Workers verify emitted reports themselves instead of 
+///        using the simulator's report queue. Errors are reported
+///        through the calling simulator in the order of the
+///        document.
+///
+///        The firmware state of the calling process is not
+///        changed. The pre-pass and all segments run in 
+///        worker processes.
+///
+/// @param data The document.
+/// @param size The size of the document in bytes.
+/// @param simulator The simulator to replay the document with.
+/// @param options Parameters of the parallel replay.
+/// @returns The number of errors detected.
+///
+size_t processAglaisDocumentParallel(const char *data, size_t size, 
+                                     Simulator &simulator,
+                                     const ParallelReplayOptions &options 
+                                        = ParallelReplayOptions{});
+
+/// @brief Replays an Aglais document that is stored in a file 
+///        in segments that run concurrently.
+/// @details The file is mapped into memory and shared by all workers. 
+///        See processAglaisDocumentParallel(...) for details.
+/// @param path The path of the file.
+/// @param simulator The simulator to replay the document with.
+/// @param options Parameters of the parallel replay.
+/// @returns The number of errors detected.
+///
+size_t processAglaisFileParallel(const char *path, 
+                                 Simulator &simulator,
+                                 const ParallelReplayOptions &options 
+                                    = ParallelReplayOptions{});
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,164 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/AglaisRecorder.h"
+#include "kaleidoscope_simulator/AglaisWriter.h"
+#include "kaleidoscope_simulator/SimulatorCore.h"
+
+namespace kaleidoscope {
+namespace simulator {
+
+namespace {
+
+// Bounds the memory used for long idle phases.
+//
+constexpr size_t max_idle_run_length = 1 << 16;
+
+} // namespace
+
+   AglaisRecorder
+      ::AglaisRecorder(std::ostream &out, AglaisFormat format,
+                       size_t flush_threshold)
+{
+   if(format == AglaisFormat::binary) {
+      writer_.reset(new AglaisBinaryWriter{out, flush_threshold});
+   }
+   else {
+      writer_.reset(new AglaisTextWriter{out, flush_threshold});
+   }
+}
+
+   AglaisRecorder
+      ::~AglaisRecorder()
+{
+   // Without a core, the end time of the open cycle is unknown.
+   //
+   uint32_t end_time = core_ ? core_->getTime() : cycle_start_time_;
+   
+   if(!finished_) {
+      this->finish(end_time);
+   }
+   
+   if(core_) {
+      core_->setAglaisRecorder(nullptr);
+   }
+}
+
+void AglaisRecorder::setFirmwareId(const char *firmware_id)
+{
+   writer_->onFirmwareId(firmware_id);
+}
+
+void AglaisRecorder::finish(uint32_t end_time)
+{
+   if(finished_) { return; }
+
+   if(cycle_open_) {
+      this->closeCycle(end_time);
+   }
+   this->flushIdleRun();
+
+   writer_->finish();
+   finished_ = true;
+}
+
+void AglaisRecorder::onCycle(uint32_t time)
+{
+   if(cycle_open_) {
+      this->closeCycle(time);
+   }
+
+   cycle_open_ = true;
+   cycle_id_ = n_cycles_++;
+   cycle_start_time_ = time;
+
+   cycle_actions_.swap(pending_actions_);
+   pending_actions_.clear();
+
+   // Releases of tapped keys go to the following cycle.
+   //
+   pending_actions_.swap(deferred_actions_);
+}
+
+void AglaisRecorder::onKeyAction(uint8_t row, uint8_t col, bool pressed)
+{
+   pending_actions_.push_back(KeyAction{row, col, pressed});
+}
+
+void AglaisRecorder::onKeyTapped(uint8_t row, uint8_t col)
+{
+   pending_actions_.push_back(KeyAction{row, col, true});
+   deferred_actions_.push_back(KeyAction{row, col, false});
+}
+
+void AglaisRecorder::onHIDReport(uint8_t id, const uint8_t *data, int length)
+{
+   cycle_reports_.push(id, length, data);
+}
+
+void AglaisRecorder::closeCycle(uint32_t end_time)
+{
+   cycle_open_ = false;
+
+   if(cycle_actions_.empty() && cycle_reports_.empty()) {
+
+      if(idle_run_durations_.empty()) {
+         idle_run_start_id_ = cycle_id_;
+         idle_run_start_time_ = cycle_start_time_;
+      }
+      idle_run_durations_.push_back(end_time - cycle_start_time_);
+
+      if(idle_run_durations_.size() >= max_idle_run_length) {
+         this->flushIdleRun();
+      }
+      return;
+   }
+
+   this->flushIdleRun();
+
+   writer_->onStartCycle(cycle_id_, cycle_start_time_);
+
+   for(const auto &action: cycle_actions_) {
+      if(action.pressed) {
+         writer_->onKeyPressed(action.row, action.col);
+      }
+      else {
+         writer_->onKeyReleased(action.row, action.col);
+      }
+   }
+   cycle_actions_.clear();
+
+   while(!cycle_reports_.empty()) {
+      auto report = cycle_reports_.front();
+      writer_->onHIDReport(report.id, report.length, report.data);
+      cycle_reports_.pop();
+   }
+
+   writer_->onEndCycle(cycle_id_, end_time);
+}
+
+void AglaisRecorder::flushIdleRun()
+{
+   if(idle_run_durations_.empty()) { return; }
+
+   writer_->onCycles(idle_run_start_id_, idle_run_start_time_, idle_run_durations_);
+   idle_run_durations_.clear();
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
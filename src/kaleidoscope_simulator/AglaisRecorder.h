@@ -0,0 +1,162 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "kaleidoscope_simulator/AglaisInterface.h"
+#include "kaleidoscope_simulator/ExpectedReportStream.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace kaleidoscope {
+namespace simulator {
+
+class AglaisWriter_;
+class SimulatorCore;
+
+/// @brief Records the simulation as an Aglais document.
+/// @details Attach a recorder to a simulator to record all key actions,
+///        the HID reports emitted by the firmware and the timing
+///        of every cycle (see Simulator::setAglaisRecorder(...)).
+///        Consecutive cycles without key actions and reports are
+///        written as runs of cycles. The resulting document can
+///        be replayed with the functions of AglaisInterface.h.
+///
+///        Aglais has no notion of tapped keys. A tap is recorded
+///        as a key press followed by a key release in the next cycle.
+///
+///        The document is written in large chunks through a buffer.
+///
+///        A recorder that is destroyed while attached to a simulator
+///        finishes its document at the simulator's current time and 
+///        detaches itself.
+///
+class AglaisRecorder
+{
+   public:
+
+      /// @brief Constructor.
+      /// @param out The stream to write the document to.
+      /// @param format The format of the document.
+      /// @param flush_threshold The buffer size in bytes that triggers
+      ///        writing to the stream.
+      ///
+      AglaisRecorder(std::ostream &out,
+                     AglaisFormat format = AglaisFormat::text,
+                     size_t flush_threshold = 1 << 20);
+
+      /// @brief Destructor.
+      /// @details Finishes the document if not finished explicitly
+      ///        and detaches the recorder from the simulator core.
+      ///
+      ~AglaisRecorder();
+
+      AglaisRecorder(const AglaisRecorder &) = delete;
+      AglaisRecorder &operator=(const AglaisRecorder &) = delete;
+
+      /// @brief Writes the id of the recorded firmware.
+      /// @details Must be called before the first cycle is recorded.
+      /// @param firmware_id The firmware id.
+      ///
+      void setFirmwareId(const char *firmware_id);
+
+      /// @brief Completes the document and writes all buffered data.
+      /// @details No further events may be recorded after the
+      ///        document is finished. Called by the destructor
+      ///        if not called explicitly.
+      /// @param end_time The end time [ms] of the last cycle.
+      ///
+      void finish(uint32_t end_time);
+
+      /// @brief Retreives the number of cycles recorded so far.
+      ///
+      uint32_t getNumCycles() const { return n_cycles_; }
+
+      /// @brief Must be called at the start of every cycle.
+      /// @param time The time [ms] at which the cycle starts.
+      ///
+      void onCycle(uint32_t time);
+
+      /// @brief Must be called for every key action.
+      /// @details Key actions are assigned to the next cycle.
+      /// @param row The key's row.
+      /// @param col The key's column.
+      /// @param pressed True if the key was pressed, false if released.
+      ///
+      void onKeyAction(uint8_t row, uint8_t col, bool pressed);
+
+      /// @brief Must be called for every tapped key.
+      /// @param row The key's row.
+      /// @param col The key's column.
+      ///
+      void onKeyTapped(uint8_t row, uint8_t col);
+
+      /// @brief Must be called for every HID report emitted by the firmware.
+      /// @param id The report id.
+      /// @param data The report's data.
+      /// @param length The length of the report's data in bytes.
+      ///
+      void onHIDReport(uint8_t id, const uint8_t *data, int length);
+
+   private:
+      
+      friend class SimulatorCore;
+
+      struct KeyAction {
+         uint8_t row;
+         uint8_t col;
+         bool pressed;
+      };
+
+      void closeCycle(uint32_t end_time);
+      void flushIdleRun();
+
+   private:
+
+      std::unique_ptr<AglaisWriter_> writer_;
+      
+      // The core the recorder is attached to, maintained by the core.
+      //
+      SimulatorCore *core_ = nullptr;
+
+      // The cycle that is currently open. Its end time is only known
+      // once the next cycle starts.
+      //
+      bool cycle_open_ = false;
+      uint32_t cycle_id_ = 0;
+      uint32_t cycle_start_time_ = 0;
+      std::vector<KeyAction> cycle_actions_;
+      ExpectedReportStream cycle_reports_;
+
+      std::vector<KeyAction> pending_actions_;
+      std::vector<KeyAction> deferred_actions_;
+
+      uint32_t idle_run_start_id_ = 0;
+      uint32_t idle_run_start_time_ = 0;
+      std::vector<uint32_t> idle_run_durations_;
+
+      uint32_t n_cycles_ = 0;
+      bool finished_ = false;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
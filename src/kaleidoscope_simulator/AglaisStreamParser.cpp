@@ -0,0 +1,405 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/AglaisStreamParser.h"
+#include "kaleidoscope_simulator/aux/exceptions.h"
+#include "aglais/Consumer_.h"
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string>
+#include <algorithm>
+
+namespace kaleidoscope {
+namespace simulator {
+   
+namespace {
+   
+inline bool isSpace(char c) {
+   return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t');
+}
+
+// Resolves the escape sequences of a quoted string.
+//
+std::string unescape(const char *s, size_t size) {
+   std::string result;
+   result.reserve(size);
+   for(size_t i = 0; i < size; ++i) {
+      if((s[i] != '\\') || (i + 1 == size)) {
+         result += s[i];
+         continue;
+      }
+      switch(s[++i]) {
+         case 'n': result += '\n'; break;
+         case 'r': result += '\r'; break;
+         default:  result += s[i]; break;
+      }
+   }
+   return result;
+}
+
+} // namespace
+   
+   AglaisStreamParser
+      ::AglaisStreamParser(aglais::Consumer_ &consumer, 
+                           size_t buffer_size,
+                           size_t max_cycles_per_batch)
+   :  consumer_(consumer),
+      buffer_size_(buffer_size),
+      max_cycles_per_batch_((max_cycles_per_batch > 0) ? max_cycles_per_batch : 1)
+{
+   cycle_durations_.reserve(std::min(max_cycles_per_batch_, size_t(4096)));
+}
+
+void AglaisStreamParser::parse(const Source &source)
+{
+   if(!buffer_) {
+      buffer_.reset(new char[buffer_size_]);
+   }
+   
+   source_ = &source;
+   data_ = buffer_.get();
+   pos_ = 0;
+   end_ = 0;
+   eof_ = false;
+   line_ = 1;
+   
+   try {
+      this->parseDocument();
+   }
+   catch(...) {
+      source_ = nullptr;
+      throw;
+   }
+   
+   source_ = nullptr;
+}
+
+AglaisStreamParser::Source AglaisStreamParser::makeSource(std::istream &in)
+{
+   return [&in](char *buffer, size_t size) -> size_t {
+      in.read(buffer, size);
+      return in.gcount();
+   };
+}
+
+AglaisStreamParser::Source AglaisStreamParser::makeSource(int fd)
+{
+   return [fd](char *buffer, size_t size) -> size_t {
+      for(;;) {
+         auto n = ::read(fd, buffer, size);
+         if(n >= 0) { return size_t(n); }
+         if(errno != EINTR) {
+            KS_T_EXCEPTION("Aglais: Failed reading from file descriptor " << fd
+               << ": " << strerror(errno))
+         }
+      }
+   };
+}
+
+void AglaisStreamParser::parse(std::istream &in)
+{
+   this->parse(makeSource(in));
+}
+
+void AglaisStreamParser::parse(int fd)
+{
+   this->parse(makeSource(fd));
+}
+
+void AglaisStreamParser::parse(const char *data, size_t size)
+{
+   source_ = nullptr;
+   data_ = data;
+   pos_ = 0;
+   end_ = size;
+   eof_ = true;
+   line_ = 1;
+   
+   this->parseDocument();
+}
+
+void AglaisStreamParser::parseDocument()
+{
+   auto document_type = this->parseUnsigned("document type");
+   auto version = this->parseUnsigned("document version");
+   
+   if(document_type != 1 || version != 1) {
+      this->error("Unsupported document type " + std::to_string(document_type)
+         + ", version " + std::to_string(version) 
+         + " (only uncompressed documents of type 1, version 1 are supported)");
+   }
+   
+   while(this->nextToken()) {
+      this->parseCommand();
+   }
+}
+
+void AglaisStreamParser::parseCommand()
+{
+   if(this->tokenIs("start_cycle")) {
+      auto cycle_id = this->parseUnsigned("cycle id");
+      auto time = this->parseUnsigned("cycle start time");
+      consumer_.onStartCycle(cycle_id, time);
+   }
+   else if(this->tokenIs("end_cycle")) {
+      auto cycle_id = this->parseUnsigned("cycle id");
+      auto time = this->parseUnsigned("cycle end time");
+      consumer_.onEndCycle(cycle_id, time);
+   }
+   else if(this->tokenIs("cycles")) {
+      this->parseCycles();
+   }
+   else if(this->tokenIs("action")) {
+      this->expectToken("action type");
+      bool pressed = this->tokenIs("key_pressed");
+      if(!pressed && !this->tokenIs("key_released")) {
+         this->error("Unknown action \'" + std::string(token_, token_size_) + "\'");
+      }
+      auto row = this->parseUnsigned("key row");
+      auto col = this->parseUnsigned("key column");
+      if(row > 255 || col > 255) {
+         this->error("Key position out of range");
+      }
+      if(pressed) {
+         consumer_.onKeyPressed(row, col);
+      }
+      else {
+         consumer_.onKeyReleased(row, col);
+      }
+   }
+   else if(this->tokenIs("reaction")) {
+      this->expectToken("reaction type");
+      if(!this->tokenIs("hid_report")) {
+         this->error("Unknown reaction \'" + std::string(token_, token_size_) + "\'");
+      }
+      this->parseHIDReport();
+   }
+   else if(this->tokenIs("set_time")) {
+      consumer_.onSetTime(this->parseUnsigned("time"));
+   }
+   else if(this->tokenIs("firmware_id")) {
+      this->expectToken("firmware id");
+      
+      // Strip the quotes.
+      //
+      const char *id = token_;
+      size_t size = token_size_;
+      if(size >= 2 && id[0] == '\"') {
+         ++id;
+         size -= 2;
+      }
+      consumer_.onFirmwareId(unescape(id, size).c_str());
+   }
+   else {
+      this->error("Unknown command \'" + std::string(token_, token_size_) + "\'");
+   }
+}
+
+void AglaisStreamParser::parseCycles()
+{
+   auto cycle_id = this->parseUnsigned("cycle id");
+   auto time = this->parseUnsigned("cycle start time");
+   auto n_cycles = this->parseUnsigned("number of cycles");
+   
+   cycle_durations_.clear();
+   uint32_t batch_duration = 0;
+   
+   for(uint32_t i = 0; i < n_cycles; ++i) {
+      
+      auto duration = this->parseUnsigned("cycle duration");
+      
+      cycle_durations_.push_back(duration);
+      batch_duration += duration;
+      
+      if(cycle_durations_.size() == max_cycles_per_batch_) {
+         consumer_.onCycles(cycle_id, time, cycle_durations_);
+         cycle_id += cycle_durations_.size();
+         time += batch_duration;
+         cycle_durations_.clear();
+         batch_duration = 0;
+      }
+   }
+   
+   if(!cycle_durations_.empty()) {
+      consumer_.onCycles(cycle_id, time, cycle_durations_);
+   }
+}
+
+void AglaisStreamParser::parseHIDReport()
+{
+   uint8_t data[256];
+   
+   auto id = this->parseUnsigned("HID report id");
+   auto length = this->parseUnsigned("HID report length");
+   
+   if(id > 255) {
+      this->error("HID report id out of range");
+   }
+   if(length > sizeof(data)) {
+      this->error("HID report too long");
+   }
+   
+   for(uint32_t i = 0; i < length; ++i) {
+      auto value = this->parseUnsigned("HID report byte");
+      if(value > 255) {
+         this->error("HID report byte out of range");
+      }
+      data[i] = value;
+   }
+   
+   consumer_.onHIDReport(id, length, data);
+}
+
+bool AglaisStreamParser::nextToken()
+{
+   // Skip whitespace.
+   //
+   for(;;) {
+      while(pos_ < end_) {
+         char c = data_[pos_];
+         if(c == '\n') {
+            ++line_;
+         }
+         else if(!isSpace(c)) {
+            break;
+         }
+         ++pos_;
+      }
+      if(pos_ < end_) { break; }
+      if(!this->refill()) { return false; }
+   }
+   
+   // Find the end of the token. A refill moves the token's beginning 
+   // to the start of the buffer.
+   //
+   bool quoted = (data_[pos_] == '\"');
+   bool escaped = false;
+   bool complete = false;
+   size_t size = 0;
+   
+   for(;;) {
+      while(pos_ + size < end_) {
+         char c = data_[pos_ + size];
+         if(quoted) {
+            if(escaped) {
+               escaped = false;
+            }
+            else if(c == '\\') {
+               escaped = true;
+            }
+            else if(size > 0 && c == '\"') {
+               ++size;
+               complete = true;
+               break;
+            }
+         }
+         else if(isSpace(c)) {
+            complete = true;
+            break;
+         }
+         ++size;
+      }
+      if(complete || !this->refill()) { break; }
+   }
+   
+   if(quoted && !complete) {
+      this->error("Unterminated string");
+   }
+   
+   token_ = data_ + pos_;
+   token_size_ = size;
+   pos_ += size;
+   
+   return true;
+}
+
+void AglaisStreamParser::expectToken(const char *what)
+{
+   if(!this->nextToken()) {
+      this->error(std::string("Unexpected end of document, expected ") + what);
+   }
+}
+
+bool AglaisStreamParser::tokenIs(const char *keyword) const
+{
+   size_t size = strlen(keyword);
+   return (token_size_ == size) && (memcmp(token_, keyword, size) == 0);
+}
+
+uint32_t AglaisStreamParser::parseUnsigned(const char *what)
+{
+   this->expectToken(what);
+   
+   uint64_t value = 0;
+   
+   for(size_t i = 0; i < token_size_; ++i) {
+      char c = token_[i];
+      if(c < '0' || c > '9') {
+         this->error(std::string("Expected ") + what + ", found \'" 
+            + std::string(token_, token_size_) + "\'");
+      }
+      value = value*10 + (c - '0');
+      if(value > 0xFFFFFFFF) {
+         this->error(std::string("Value of ") + what + " out of range");
+      }
+   }
+   
+   return value;
+}
+
+bool AglaisStreamParser::refill()
+{
+   if(eof_ || !source_) { 
+      eof_ = true;
+      return false; 
+   }
+   
+   // Keep the data that has not been consumed yet.
+   //
+   char *buffer = buffer_.get();
+   size_t remaining = end_ - pos_;
+   memmove(buffer, buffer + pos_, remaining);
+   pos_ = 0;
+   end_ = remaining;
+   
+   if(end_ == buffer_size_) {
+      this->error("Token exceeds the input buffer size of " 
+         + std::to_string(buffer_size_) + " bytes");
+   }
+   
+   size_t n = (*source_)(buffer + end_, buffer_size_ - end_);
+   
+   if(n == 0) {
+      eof_ = true;
+      return false;
+   }
+   
+   end_ += n;
+   
+   return true;
+}
+
+void AglaisStreamParser::error(const std::string &what) const
+{
+   KS_T_EXCEPTION("Aglais: line " << line_ << ": " << what)
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,136 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace aglais {
+class Consumer_;
+} // namespace aglais
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief A parser for Aglais text documents that reads its input 
+///        incrementally.
+/// @details The input is read in chunks into a buffer of fixed size. 
+///        Every command is passed to the consumer as soon as it has
+///        been parsed. Long runs of cycles are passed on in batches 
+///        of limited size. Thus, the memory required does not 
+///        depend on the size of the document.
+///
+class AglaisStreamParser
+{
+   public:
+      
+      /// @brief A function that reads the next chunk of input.
+      /// @details The function writes at most size bytes to buffer.
+      /// @returns The number of bytes read. Zero signals the end of input.
+      ///
+      typedef std::function<size_t(char *buffer, size_t size)> Source;
+      
+      /// @brief Creates a source that reads from a stream.
+      ///
+      static Source makeSource(std::istream &in);
+      
+      /// @brief Creates a source that reads from a file descriptor.
+      ///
+      static Source makeSource(int fd);
+      
+      /// @brief Constructor.
+      /// @param consumer The consumer that receives the parsed commands.
+      /// @param buffer_size The size of the input buffer in bytes. No
+      ///        single token of the document may exceed this size.
+      /// @param max_cycles_per_batch The max. number of cycle durations
+      ///        that are passed to the consumer with a single call 
+      ///        to onCycles.
+      ///
+      AglaisStreamParser(aglais::Consumer_ &consumer, 
+                         size_t buffer_size = 64*1024,
+                         size_t max_cycles_per_batch = 4096);
+      
+      /// @brief Parses a document that is provided by a source function.
+      ///
+      void parse(const Source &source);
+      
+      /// @brief Parses a document that is read from a stream.
+      ///
+      void parse(std::istream &in);
+      
+      /// @brief Parses a document that is read from a file descriptor.
+      ///
+      void parse(int fd);
+      
+      /// @brief Parses a document that resides in memory.
+      /// @details The document is parsed in place without being copied.
+      /// @param data The document's text.
+      /// @param size The size of the document in bytes.
+      ///
+      void parse(const char *data, size_t size);
+      
+      /// @brief Retreives the line that is currently being parsed.
+      ///
+      uint64_t getLine() const { return line_; }
+      
+   private:
+      
+      void parseDocument();
+      void parseCommand();
+      void parseCycles();
+      void parseHIDReport();
+      
+      bool nextToken();
+      void expectToken(const char *what);
+      bool tokenIs(const char *keyword) const;
+      uint32_t parseUnsigned(const char *what);
+      
+      bool refill();
+      
+      [[noreturn]] void error(const std::string &what) const;
+      
+   private:
+      
+      aglais::Consumer_ &consumer_;
+      
+      size_t buffer_size_;
+      std::unique_ptr<char[]> buffer_;
+      const Source *source_ = nullptr;
+      
+      const char *data_ = nullptr;
+      size_t pos_ = 0;
+      size_t end_ = 0;
+      bool eof_ = false;
+      
+      const char *token_ = nullptr;
+      size_t token_size_ = 0;
+      
+      uint64_t line_ = 1;
+      
+      size_t max_cycles_per_batch_;
+      std::vector<uint32_t> cycle_durations_;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,321 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/AglaisWriter.h"
+
+#include <string.h>
+
+namespace kaleidoscope {
+namespace simulator {
+   
+using namespace aglais_binary;
+   
+   AglaisWriter_
+      ::AglaisWriter_(std::ostream &out, size_t flush_threshold)
+   :  out_(out),
+      flush_threshold_(flush_threshold)
+{
+   buffer_.reserve(flush_threshold_ + 1024);
+}
+
+void AglaisWriter_::finish()
+{
+   if(finished_) { return; }
+   
+   this->writeTrailer();
+   this->flush();
+   out_.flush();
+   
+   finished_ = true;
+}
+
+void AglaisWriter_::appendUnsigned(uint32_t value)
+{
+   char digits[10];
+   int n = 0;
+   do {
+      digits[n++] = char('0' + value % 10);
+      value /= 10;
+   } while(value);
+   
+   while(n) {
+      buffer_ += digits[--n];
+   }
+}
+
+void AglaisWriter_::flush()
+{
+   if(buffer_.empty()) { return; }
+   
+   out_.write(buffer_.data(), buffer_.size());
+   n_flushed_ += buffer_.size();
+   buffer_.clear();
+}
+
+//******************************************************************************
+// AglaisTextWriter
+//******************************************************************************
+
+   AglaisTextWriter
+      ::AglaisTextWriter(std::ostream &out, size_t flush_threshold)
+   :  AglaisWriter_(out, flush_threshold)
+{
+   // Document type and version
+   //
+   buffer_ += "1 1\n";
+}
+
+   AglaisTextWriter
+      ::~AglaisTextWriter()
+{
+   this->finish();
+}
+
+void AglaisTextWriter::onFirmwareId(const char *firmware_id)
+{
+   buffer_ += "firmware_id \"";
+   
+   // Quotes, backslashes and line breaks would end the string 
+   // or the line prematurely.
+   //
+   for(const char *c = firmware_id; *c; ++c) {
+      switch(*c) {
+         case '\"':  buffer_ += "\\\""; break;
+         case '\\':  buffer_ += "\\\\"; break;
+         case '\n':  buffer_ += "\\n"; break;
+         case '\r':  buffer_ += "\\r"; break;
+         default:    buffer_ += *c; break;
+      }
+   }
+   
+   buffer_ += "\"\n";
+   this->flushIfFull();
+}
+
+void AglaisTextWriter::onStartCycle(uint32_t cycle_id, uint32_t cycle_start_time)
+{
+   buffer_ += "start_cycle ";
+   this->appendUnsigned(cycle_id);
+   buffer_ += ' ';
+   this->appendUnsigned(cycle_start_time);
+   buffer_ += '\n';
+   this->flushIfFull();
+}
+
+void AglaisTextWriter::onEndCycle(uint32_t cycle_id, uint32_t cycle_end_time)
+{
+   buffer_ += "end_cycle ";
+   this->appendUnsigned(cycle_id);
+   buffer_ += ' ';
+   this->appendUnsigned(cycle_end_time);
+   buffer_ += '\n';
+   this->flushIfFull();
+}
+
+void AglaisTextWriter::onKeyPressed(uint8_t row, uint8_t col)
+{
+   buffer_ += "action key_pressed ";
+   this->appendUnsigned(row);
+   buffer_ += ' ';
+   this->appendUnsigned(col);
+   buffer_ += '\n';
+   this->flushIfFull();
+}
+
+void AglaisTextWriter::onKeyReleased(uint8_t row, uint8_t col)
+{
+   buffer_ += "action key_released ";
+   this->appendUnsigned(row);
+   buffer_ += ' ';
+   this->appendUnsigned(col);
+   buffer_ += '\n';
+   this->flushIfFull();
+}
+
+void AglaisTextWriter::onHIDReport(uint8_t id, int length, const uint8_t *data)
+{
+   buffer_ += "reaction hid_report ";
+   this->appendUnsigned(id);
+   buffer_ += ' ';
+   this->appendUnsigned(length);
+   buffer_ += ' ';
+   for(int i = 0; i < length; ++i) {
+      this->appendUnsigned(data[i]);
+      buffer_ += ' ';
+   }
+   buffer_ += '\n';
+   this->flushIfFull();
+}
+
+void AglaisTextWriter::onSetTime(uint32_t time)
+{
+   buffer_ += "set_time ";
+   this->appendUnsigned(time);
+   buffer_ += '\n';
+   this->flushIfFull();
+}
+
+void AglaisTextWriter::onCycles(uint32_t start_cycle_id, uint32_t start_time_id, 
+                                const std::vector<uint32_t> &cycle_durations)
+{
+   buffer_ += "cycles ";
+   this->appendUnsigned(start_cycle_id);
+   buffer_ += ' ';
+   this->appendUnsigned(start_time_id);
+   buffer_ += ' ';
+   this->appendUnsigned(cycle_durations.size());
+   buffer_ += ' ';
+   for(auto duration: cycle_durations) {
+      this->appendUnsigned(duration);
+      buffer_ += ' ';
+      this->flushIfFull();
+   }
+   buffer_ += '\n';
+   this->flushIfFull();
+}
+
+//******************************************************************************
+// AglaisBinaryWriter
+//******************************************************************************
+
+   AglaisBinaryWriter
+      ::AglaisBinaryWriter(std::ostream &out, size_t flush_threshold)
+   :  AglaisWriter_(out, flush_threshold)
+{
+   buffer_.append(magic, sizeof(magic));
+   buffer_ += char(version);
+}
+
+   AglaisBinaryWriter
+      ::~AglaisBinaryWriter()
+{
+   this->finish();
+}
+
+void AglaisBinaryWriter::onFirmwareId(const char *firmware_id)
+{
+   uint32_t length = strlen(firmware_id);
+   buffer_ += char(tag_firmware_id);
+   this->appendVarint(length);
+   buffer_.append(firmware_id, length);
+   this->flushIfFull();
+}
+
+void AglaisBinaryWriter::onStartCycle(uint32_t cycle_id, uint32_t cycle_start_time)
+{
+   buffer_ += char(tag_start_cycle);
+   this->appendVarint(zigzagEncode(cycle_id, state_.next_cycle_id));
+   this->appendVarint(zigzagEncode(cycle_start_time, state_.time));
+   state_.onStartCycle(cycle_id, cycle_start_time);
+   this->flushIfFull();
+}
+
+void AglaisBinaryWriter::onEndCycle(uint32_t cycle_id, uint32_t cycle_end_time)
+{
+   buffer_ += char(tag_end_cycle);
+   this->appendVarint(zigzagEncode(cycle_id, state_.next_cycle_id));
+   this->appendVarint(zigzagEncode(cycle_end_time, state_.time));
+   state_.onEndCycle(cycle_id, cycle_end_time);
+   this->flushIfFull();
+}
+
+void AglaisBinaryWriter::onKeyPressed(uint8_t row, uint8_t col)
+{
+   buffer_ += char(tag_key_pressed);
+   buffer_ += char(row);
+   buffer_ += char(col);
+   this->flushIfFull();
+}
+
+void AglaisBinaryWriter::onKeyReleased(uint8_t row, uint8_t col)
+{
+   buffer_ += char(tag_key_released);
+   buffer_ += char(row);
+   buffer_ += char(col);
+   this->flushIfFull();
+}
+
+void AglaisBinaryWriter::onHIDReport(uint8_t id, int length, const uint8_t *data)
+{
+   buffer_ += char(tag_hid_report);
+   buffer_ += char(id);
+   this->appendVarint(length);
+   buffer_.append(reinterpret_cast<const char*>(data), length);
+   this->flushIfFull();
+}
+
+void AglaisBinaryWriter::onSetTime(uint32_t time)
+{
+   buffer_ += char(tag_set_time);
+   this->appendVarint(zigzagEncode(time, state_.time));
+   state_.onSetTime(time);
+   this->flushIfFull();
+}
+
+void AglaisBinaryWriter::onCycles(uint32_t start_cycle_id, uint32_t start_time_id, 
+                                  const std::vector<uint32_t> &cycle_durations)
+{
+   buffer_ += char(tag_cycles);
+   this->appendVarint(zigzagEncode(start_cycle_id, state_.next_cycle_id));
+   this->appendVarint(zigzagEncode(start_time_id, state_.time));
+   this->appendVarint(cycle_durations.size());
+   
+   uint32_t time = start_time_id;
+   size_t n = cycle_durations.size();
+   
+   for(size_t i = 0; i < n; i += 2) {
+      
+      uint32_t low = cycle_durations[i];
+      uint32_t high = (i + 1 < n) ? cycle_durations[i + 1] : 0;
+      time += low + high;
+      
+      uint8_t low_nibble = (low < nibble_escape) ? low : nibble_escape;
+      uint8_t high_nibble = (high < nibble_escape) ? high : nibble_escape;
+      
+      buffer_ += char(low_nibble | (high_nibble << 4));
+      
+      if(low_nibble == nibble_escape) {
+         this->appendVarint(low);
+      }
+      if(high_nibble == nibble_escape) {
+         this->appendVarint(high);
+      }
+      
+      this->flushIfFull();
+   }
+   
+   state_.onCycles(start_cycle_id, cycle_durations.size(), time);
+   this->flushIfFull();
+}
+
+void AglaisBinaryWriter::writeTrailer()
+{
+   buffer_ += char(tag_end);
+}
+
+void AglaisBinaryWriter::appendVarint(uint32_t value)
+{
+   while(value >= 0x80) {
+      buffer_ += char((value & 0x7F) | 0x80);
+      value >>= 7;
+   }
+   buffer_ += char(value);
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,138 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "aglais/Consumer_.h"
+#include "kaleidoscope_simulator/AglaisBinaryFormat.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief Common base of consumers that write Aglais documents.
+/// @details Output is collected in a memory buffer and written to
+///        the output stream in large chunks.
+///
+class AglaisWriter_ : public aglais::Consumer_
+{
+   public:
+      
+      /// @brief Constructor.
+      /// @param out The stream to write the document to.
+      /// @param flush_threshold The buffer size in bytes that triggers
+      ///        writing to the stream.
+      ///
+      AglaisWriter_(std::ostream &out, size_t flush_threshold = 1 << 20);
+      
+      /// @brief Completes the document and writes all buffered data.
+      /// @details No further events may be consumed after the
+      ///        document is finished. Called by the destructor
+      ///        if not called explicitly.
+      ///
+      void finish();
+      
+      /// @brief Retreives the number of bytes written so far, including
+      ///        buffered data.
+      ///
+      uint64_t getSize() const { return n_flushed_ + buffer_.size(); }
+      
+   protected:
+      
+      virtual void writeTrailer() {}
+      
+      void appendUnsigned(uint32_t value);
+      void flushIfFull() {
+         if(buffer_.size() >= flush_threshold_) { this->flush(); }
+      }
+      void flush();
+      
+   protected:
+      
+      std::string buffer_;
+      
+   private:
+      
+      std::ostream &out_;
+      size_t flush_threshold_;
+      uint64_t n_flushed_ = 0;
+      bool finished_ = false;
+};
+
+/// @brief A consumer that writes an Aglais text document.
+///
+class AglaisTextWriter : public AglaisWriter_
+{
+   public:
+      
+      AglaisTextWriter(std::ostream &out, size_t flush_threshold = 1 << 20);
+      
+      ~AglaisTextWriter();
+      
+      virtual void onFirmwareId(const char *firmware_id) override;
+      virtual void onStartCycle(uint32_t cycle_id, uint32_t cycle_start_time) override;
+      virtual void onEndCycle(uint32_t cycle_id, uint32_t cycle_end_time) override;
+      virtual void onKeyPressed(uint8_t row, uint8_t col) override;
+      virtual void onKeyReleased(uint8_t row, uint8_t col) override;
+      virtual void onHIDReport(uint8_t id, int length, const uint8_t *data) override;
+      virtual void onSetTime(uint32_t time) override;
+      virtual void onCycles(uint32_t start_cycle_id, uint32_t start_time_id, 
+                            const std::vector<uint32_t> &cycle_durations) override;
+};
+
+/// @brief A consumer that writes a binary Aglais document.
+/// @details See AglaisBinaryFormat.h for a description of the format.
+///
+class AglaisBinaryWriter : public AglaisWriter_
+{
+   public:
+      
+      AglaisBinaryWriter(std::ostream &out, size_t flush_threshold = 1 << 20);
+      
+      ~AglaisBinaryWriter();
+      
+      virtual void onFirmwareId(const char *firmware_id) override;
+      virtual void onStartCycle(uint32_t cycle_id, uint32_t cycle_start_time) override;
+      virtual void onEndCycle(uint32_t cycle_id, uint32_t cycle_end_time) override;
+      virtual void onKeyPressed(uint8_t row, uint8_t col) override;
+      virtual void onKeyReleased(uint8_t row, uint8_t col) override;
+      virtual void onHIDReport(uint8_t id, int length, const uint8_t *data) override;
+      virtual void onSetTime(uint32_t time) override;
+      virtual void onCycles(uint32_t start_cycle_id, uint32_t start_time_id, 
+                            const std::vector<uint32_t> &cycle_durations) override;
+      
+   protected:
+      
+      virtual void writeTrailer() override;
+      
+   private:
+      
+      void appendVarint(uint32_t value);
+      
+   private:
+      
+      aglais_binary::DeltaState state_;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
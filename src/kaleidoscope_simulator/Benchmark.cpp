@@ -0,0 +1,207 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/Benchmark.h"
+#include "kaleidoscope_simulator/Simulator.h"
+
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+namespace kaleidoscope {
+namespace simulator {
+   
+namespace {
+   
+uint64_t percentile(const std::vector<uint64_t> &sorted, double p)
+{
+   if(sorted.empty()) { return 0; }
+   size_t index = size_t(p*(sorted.size() - 1) + 0.5);
+   return sorted[index];
+}
+
+// Writes a string as JSON string literal.
+//
+void writeJSONString(std::ostream &out, const std::string &s)
+{
+   static constexpr char hex_digits[] = "0123456789abcdef";
+   
+   out << '"';
+   for(const char c: s) {
+      switch(c) {
+         case '"': out << "\\\""; break;
+         case '\\': out << "\\\\"; break;
+         case '\n': out << "\\n"; break;
+         case '\r': out << "\\r"; break;
+         case '\t': out << "\\t"; break;
+         default:
+            if((unsigned char)c < 0x20) {
+               out << "\\u00" << hex_digits[c >> 4] << hex_digits[c & 0xF];
+            }
+            else {
+               out << c;
+            }
+      }
+   }
+   out << '"';
+}
+
+} // namespace
+   
+   Benchmark::Benchmark(Simulator &simulator, const BenchmarkOptions &options)
+   :  simulator_(simulator),
+      options_(options)
+{
+   simulator_.takeSnapshot(initial_state_);
+}
+
+BenchmarkResult Benchmark::run(const char *name, 
+                               const SetupFunction &setup,
+                               const CycleFunction &before_cycle)
+{
+   typedef std::chrono::steady_clock Clock;
+   
+   simulator_.restoreSnapshot(initial_state_);
+   
+   if(setup) { setup(); }
+   
+   uint32_t cycle = 0;
+   
+   for(uint32_t i = 0; i < options_.n_warmup_cycles; ++i, ++cycle) {
+      if(before_cycle) { before_cycle(cycle); }
+      simulator_.cycle(true /*suppress cycle log info*/);
+   }
+   
+   BenchmarkResult result;
+   result.name = name;
+   result.n_trials = options_.n_trials;
+   result.n_cycles_per_trial = options_.n_cycles_per_trial;
+   result.histogram.resize(64, 0);
+   
+   std::vector<uint64_t> samples;
+   samples.reserve(size_t(options_.n_trials)*options_.n_cycles_per_trial);
+   
+   std::vector<double> trial_means;
+   trial_means.reserve(options_.n_trials);
+   
+   for(uint32_t trial = 0; trial < options_.n_trials; ++trial) {
+      
+      uint64_t trial_sum = 0;
+      
+      for(uint32_t i = 0; i < options_.n_cycles_per_trial; ++i, ++cycle) {
+         
+         if(before_cycle) { before_cycle(cycle); }
+         
+         auto start = Clock::now();
+         simulator_.cycle(true /*suppress cycle log info*/);
+         auto end = Clock::now();
+         
+         uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+         
+         samples.push_back(ns);
+         trial_sum += ns;
+         
+         unsigned bucket = (ns == 0) ? 0 : 63 - __builtin_clzll(ns);
+         ++result.histogram[bucket];
+      }
+      
+      trial_means.push_back(double(trial_sum)/std::max(options_.n_cycles_per_trial, uint32_t(1)));
+   }
+   
+   // Trim trailing empty histogram buckets
+   //
+   while(!result.histogram.empty() && result.histogram.back() == 0) {
+      result.histogram.pop_back();
+   }
+   
+   if(!trial_means.empty()) {
+      double sum = 0.0;
+      for(auto m: trial_means) { sum += m; }
+      result.trial_mean_ns = sum/trial_means.size();
+      
+      double sq_sum = 0.0;
+      for(auto m: trial_means) { 
+         sq_sum += (m - result.trial_mean_ns)*(m - result.trial_mean_ns); 
+      }
+      result.trial_stddev_ns = (trial_means.size() > 1) 
+         ? std::sqrt(sq_sum/(trial_means.size() - 1)) : 0.0;
+      result.trial_min_ns = *std::min_element(trial_means.begin(), trial_means.end());
+   }
+   
+   std::sort(samples.begin(), samples.end());
+   
+   result.p50_ns = percentile(samples, 0.50);
+   result.p90_ns = percentile(samples, 0.90);
+   result.p99_ns = percentile(samples, 0.99);
+   result.max_ns = samples.empty() ? 0 : samples.back();
+   
+   results_.push_back(result);
+   
+   return result;
+}
+
+void Benchmark::logResults() const
+{
+   for(const auto &r: results_) {
+      simulator_.log() << "Benchmark " << r.name << ": " 
+         << r.n_trials << " trials x " << r.n_cycles_per_trial << " cycles";
+      simulator_.log() << "   cycle mean [ns]: " << r.trial_mean_ns 
+         << " +- " << r.trial_stddev_ns << " (best trial " << r.trial_min_ns << ")";
+      simulator_.log() << "   cycle p50/p90/p99/max [ns]: " 
+         << r.p50_ns << '/' << r.p90_ns << '/' << r.p99_ns << '/' << r.max_ns;
+   }
+}
+
+void Benchmark::writeJSON(std::ostream &out) const
+{
+   out << "{\n";
+   out << "  \"warmup_cycles\": " << options_.n_warmup_cycles << ",\n";
+   out << "  \"scenarios\": [";
+   
+   bool first = true;
+   for(const auto &r: results_) {
+      out << (first ? "\n" : ",\n");
+      first = false;
+      
+      out << "    {\n";
+      out << "      \"name\": ";
+      writeJSONString(out, r.name);
+      out << ",\n";
+      out << "      \"trials\": " << r.n_trials << ",\n";
+      out << "      \"cycles_per_trial\": " << r.n_cycles_per_trial << ",\n";
+      out << "      \"mean_ns\": " << r.trial_mean_ns << ",\n";
+      out << "      \"stddev_ns\": " << r.trial_stddev_ns << ",\n";
+      out << "      \"best_trial_ns\": " << r.trial_min_ns << ",\n";
+      out << "      \"p50_ns\": " << r.p50_ns << ",\n";
+      out << "      \"p90_ns\": " << r.p90_ns << ",\n";
+      out << "      \"p99_ns\": " << r.p99_ns << ",\n";
+      out << "      \"max_ns\": " << r.max_ns << ",\n";
+      out << "      \"histogram_log2_ns\": [";
+      for(size_t i = 0; i < r.histogram.size(); ++i) {
+         out << (i ? ", " : "") << r.histogram[i];
+      }
+      out << "]\n";
+      out << "    }";
+   }
+   
+   out << "\n  ]\n";
+   out << "}\n";
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,143 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "kaleidoscope_simulator/FirmwareSnapshot.h"
+
+#include <stdint.h>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace kaleidoscope {
+namespace simulator {
+
+class Simulator;
+
+/// @brief Configuration of a benchmark run.
+///
+struct BenchmarkOptions
+{
+   /// @brief Number of cycles that are run before measuring starts.
+   ///
+   uint32_t n_warmup_cycles = 1000;
+
+   /// @brief Number of independent trials.
+   ///
+   uint32_t n_trials = 10;
+
+   /// @brief Number of cycles that are measured per trial.
+   ///
+   uint32_t n_cycles_per_trial = 10000;
+};
+
+/// @brief The results of a benchmark scenario.
+/// @details All durations are wall clock times in nanoseconds.
+///
+struct BenchmarkResult
+{
+   std::string name;
+
+   uint32_t n_trials = 0;
+   uint32_t n_cycles_per_trial = 0;
+
+   /// @brief Mean, standard deviation and minimum of the per trial
+   ///        average cycle duration.
+   ///
+   double trial_mean_ns = 0.0;
+   double trial_stddev_ns = 0.0;
+   double trial_min_ns = 0.0;
+
+   /// @brief Percentiles of the per cycle latency over all trials.
+   ///
+   uint64_t p50_ns = 0;
+   uint64_t p90_ns = 0;
+   uint64_t p99_ns = 0;
+   uint64_t max_ns = 0;
+
+   /// @brief A histogram of per cycle latencies. Bucket i counts
+   ///        cycles that took [2^i, 2^(i+1)) ns.
+   ///
+   std::vector<uint64_t> histogram;
+};
+
+/// @brief A harness that measures the cost of firmware cycles.
+/// @details Every scenario starts from the firmware state that was 
+///        present when the benchmark object was created. Each scenario
+///        is warmed up before a number of trials is measured. Every
+///        single cycle is timed with a monotonic high resolution clock.
+///
+class Benchmark
+{
+   public:
+
+      /// @brief A function that is called once before a scenario is warmed up.
+      ///
+      typedef std::function<void()> SetupFunction;
+
+      /// @brief A function that is called before every cycle of a scenario.
+      /// @details The function is passed the number of the cycle 
+      ///        within the scenario (counting warm-up cycles).
+      ///
+      typedef std::function<void(uint32_t cycle)> CycleFunction;
+
+      /// @brief Constructor.
+      /// @param simulator The simulator to run the benchmark with.
+      /// @param options The benchmark configuration.
+      ///
+      Benchmark(Simulator &simulator, const BenchmarkOptions &options = BenchmarkOptions{});
+
+      /// @brief Runs a benchmark scenario.
+      /// @param name The name of the scenario.
+      /// @param setup A function that prepares the scenario (may be empty).
+      /// @param before_cycle A function that is called before every cycle
+      ///        (may be empty).
+      /// @returns A copy of the results of the scenario. They are
+      ///        also stored with the results of all scenarios 
+      ///        (see getResults()).
+      ///
+      BenchmarkResult run(const char *name, 
+                          const SetupFunction &setup = SetupFunction{},
+                          const CycleFunction &before_cycle = CycleFunction{});
+
+      /// @brief Writes a human readable table of all results to 
+      ///        the simulator's log.
+      ///
+      void logResults() const;
+
+      /// @brief Writes all results as JSON.
+      /// @param out The stream to write to.
+      ///
+      void writeJSON(std::ostream &out) const;
+
+      /// @brief Access the results of all scenarios run so far.
+      ///
+      const std::vector<BenchmarkResult> &getResults() const { return results_; }
+
+   private:
+
+      Simulator &simulator_;
+      BenchmarkOptions options_;
+      FirmwareSnapshot initial_state_;
+      std::vector<BenchmarkResult> results_;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
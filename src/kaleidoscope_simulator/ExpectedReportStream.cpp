@@ -0,0 +1,176 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Important: Leave stdint.h the first header as some other Kaleidoscope
+//            related stuff depends on standard integer types to be defined
+//            (Arduino defines them auto-magically).
+//
+#include <stdint.h>
+
+#include "kaleidoscope_simulator/ExpectedReportStream.h"
+#include "kaleidoscope_simulator/reports/HIDReport.h"
+#include "kaleidoscope_simulator/reports/ReportDelta.h"
+
+#include <assert.h>
+#include <sstream>
+
+namespace kaleidoscope {
+namespace simulator {
+
+constexpr size_t ExpectedReportStream::header_size;
+
+void ExpectedReportStream::push(uint8_t id, int length, const uint8_t *data)
+{
+   assert((length >= 0) && (length <= 0xFFFF));
+
+   // Records are appended behind the ones that are still pending.
+   // The buffer's capacity is kept when it is emptied.
+   //
+   size_t pos = buffer_.size();
+   buffer_.resize(pos + header_size + length);
+
+   uint8_t *record = buffer_.data() + pos;
+   record[0] = id;
+   record[1] = uint8_t(length & 0xFF);
+   record[2] = uint8_t(length >> 8);
+   memcpy(record + header_size, data, length);
+
+   ++n_pending_;
+}
+
+ExpectedReportStream::Record ExpectedReportStream::front() const
+{
+   assert(!this->empty());
+
+   const uint8_t *record = buffer_.data() + read_pos_;
+
+   return Record{
+      record[0],
+      int(record[1]) | (int(record[2]) << 8),
+      record + header_size
+   };
+}
+
+void ExpectedReportStream::Record::print(std::ostream &out) const
+{
+   out << (int)id << " |";
+   for(int i = 0; i < length; ++i) {
+      out << ' ' << (int)data[i];
+   }
+}
+
+bool ExpectedReportStream::verify(uint8_t id, const uint8_t *data, int length, 
+                                  std::string &difference)
+{
+   Record emitted{id, length, data};
+   
+   if(this->empty()) {
+      std::ostringstream out;
+      out << "unexpected: ";
+      emitted.print(out);
+      difference = out.str();
+      return false;
+   }
+   
+   auto expected = this->front();
+   
+   if(expected.matches(id, data, length)) {
+      this->pop();
+      return true;
+   }
+   
+   std::ostringstream out;
+   out << "differs, expected: ";
+   expected.print(out);
+   out << ", emitted: ";
+   emitted.print(out);
+   
+   // Only complete reports of known types can be compared.
+   //
+   auto expected_type = HIDReport::typeFromId(expected.id);
+   if((expected_type != HIDReportType::none) 
+         && (HIDReport::typeFromId(id) == expected_type)
+         && (size_t(expected.length) == HIDReport::getDataSize(expected_type))
+         && (size_t(length) == HIDReport::getDataSize(expected_type))) {
+      out << ", emitted relative to expected:";
+      ReportDelta{HIDReport{expected.id, expected.data}, HIDReport{id, data}}
+         .print(out);
+   }
+   
+   difference = out.str();
+   
+   this->pop();
+   
+   return false;
+}
+
+size_t ExpectedReportStream::verifyCycle(ExpectedReportStream &emitted, 
+                                         std::vector<std::string> &differences)
+{
+   // Most cycles neither expect nor emit reports.
+   //
+   if(this->empty() && emitted.empty()) { return 0; }
+   
+   size_t n_differences = 0;
+   
+   if(emitted.getNumPending() != this->getNumPending()) {
+      differences.push_back("Expected " + std::to_string(this->getNumPending())
+         + " HID report(s) but " + std::to_string(emitted.getNumPending()) 
+         + " were emitted");
+      ++n_differences;
+   }
+   
+   std::string difference;
+   size_t i = 0;
+   
+   for(; !emitted.empty(); ++i) {
+      auto report = emitted.front();
+      if(!this->verify(report.id, report.data, report.length, difference)) {
+         differences.push_back("HID report " + std::to_string(i) + ' ' + difference);
+         ++n_differences;
+      }
+      emitted.pop();
+   }
+   
+   for(; !this->empty(); ++i) {
+      std::ostringstream out;
+      out << "HID report " << i << " missing: ";
+      this->front().print(out);
+      differences.push_back(out.str());
+      ++n_differences;
+      this->pop();
+   }
+   
+   return n_differences;
+}
+
+void ExpectedReportStream::pop()
+{
+   assert(!this->empty());
+
+   const uint8_t *record = buffer_.data() + read_pos_;
+   read_pos_ += header_size + (size_t(record[1]) | (size_t(record[2]) << 8));
+   --n_pending_;
+
+   if(read_pos_ == buffer_.size()) {
+      this->clear();
+   }
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
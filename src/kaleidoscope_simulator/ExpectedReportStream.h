@@ -0,0 +1,140 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief A queue of expected HID reports.
+/// @details Reports are stored back to back as (id, length, data)
+///        records in a single contiguous buffer. The buffer is
+///        reused once all records have been consumed. Thus,
+///        once the buffer has grown to the max. number of reports
+///        expected at a time, no further memory is allocated.
+///
+///        verify(...) and verifyCycle(...) implement the comparison of
+///        emitted and expected reports that is shared by all replays of 
+///        Aglais documents.
+///
+class ExpectedReportStream
+{
+   public:
+
+      /// @brief A view of a record of the stream.
+      /// @details The data is only valid until the next record is pushed.
+      ///
+      struct Record {
+
+         uint8_t id;
+         int length;
+         const uint8_t *data;
+
+         /// @brief Checks if a report matches the record.
+         ///
+         bool matches(uint8_t report_id, const uint8_t *report_data,
+                      int report_length) const {
+            return (id == report_id)
+                && (length == report_length)
+                && (memcmp(data, report_data, length) == 0);
+         }
+
+         /// @brief Writes the record as id followed by the data bytes.
+         ///
+         void print(std::ostream &out) const;
+      };
+
+      /// @brief Appends an expected report.
+      /// @param id The report id.
+      /// @param length The length of the report's data in bytes.
+      /// @param data The report's data.
+      ///
+      void push(uint8_t id, int length, const uint8_t *data);
+
+      /// @brief Checks if there are no records left.
+      ///
+      bool empty() const { return read_pos_ == buffer_.size(); }
+
+      /// @brief Retreives the number of records left.
+      ///
+      size_t getNumPending() const { return n_pending_; }
+
+      /// @brief Access the next record.
+      /// @details Must not be called if the stream is empty.
+      ///
+      Record front() const;
+
+      /// @brief Removes the next record.
+      /// @details Must not be called if the stream is empty.
+      ///
+      void pop();
+
+      /// @brief Removes all records.
+      ///
+      void clear() {
+         buffer_.clear();
+         read_pos_ = 0;
+         n_pending_ = 0;
+      }
+
+      /// @brief Verifies an emitted report against the next record.
+      /// @details The record, if any, is removed. If the report 
+      ///        is not expected or differs from the record, the 
+      ///        difference is described. For reports of the same
+      ///        type, the description includes the delta of the
+      ///        emitted report relative to the expected one.
+      /// @param id The id of the emitted report.
+      /// @param data The data of the emitted report.
+      /// @param length The length of the report's data in bytes.
+      /// @param difference Set to a description of the difference
+      ///        if the report does not match.
+      /// @returns True if the report matches the record.
+      ///
+      bool verify(uint8_t id, const uint8_t *data, int length, 
+                  std::string &difference);
+
+      /// @brief Verifies the reports emitted during a cycle against the
+      ///        records.
+      /// @details Reports and records are compared in order. 
+      ///        Both streams are emptied.
+      /// @param emitted The reports emitted during the cycle.
+      /// @param differences Every difference found is appended as
+      ///        a description of its own.
+      /// @returns The number of differences found.
+      ///
+      size_t verifyCycle(ExpectedReportStream &emitted, 
+                         std::vector<std::string> &differences);
+
+   private:
+
+      static constexpr size_t header_size = 3;
+
+      std::vector<uint8_t> buffer_;
+      size_t read_pos_ = 0;
+      size_t n_pending_ = 0;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
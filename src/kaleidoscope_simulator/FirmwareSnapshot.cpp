@@ -0,0 +1,291 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/FirmwareSnapshot.h"
+#include "kaleidoscope_simulator/aux/exceptions.h"
+
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+#ifdef __linux__
+
+#include <elf.h>
+#include <link.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Symbols provided by the GNU toolchain that mark the start of the
+// initialized data segment and the end of the bss segment of the
+// executable.
+//
+extern "C" char __data_start[];
+extern "C" char _end[];
+
+#endif
+
+namespace kaleidoscope {
+namespace simulator {
+
+#ifdef __linux__
+
+namespace {
+
+bool hasPrefix(const char *name, const char *prefix)
+{
+   return strncmp(name, prefix, strlen(prefix)) == 0;
+}
+
+// Mangled name prefixes of objects that belong to the simulator,
+// to papilio, to the Aglais parser or to the C++ standard library.
+// Function local statics (_ZZ...) are covered by the second set.
+//
+const char *excluded_prefixes[] = {
+   "_ZN12kaleidoscope9simulator",
+   "_ZN7papilio",
+   "_ZN6aglais",
+   "_ZSt",
+   "_ZNSt",
+   "_ZN9__gnu_cxx",
+   "_ZN10__cxxabiv1",
+   "_ZZN12kaleidoscope9simulator",
+   "_ZZNK12kaleidoscope9simulator",
+   "_ZZN7papilio",
+   "_ZZNK7papilio",
+   "_ZZN6aglais",
+   "_ZZNK6aglais",
+   "_ZZNSt",
+   "_ZZNKSt",
+   "_ZZSt",
+   "_ZZN9__gnu_cxx"
+};
+
+// Objects of the C runtime that are copied into the executable.
+//
+const char *excluded_names[] = {
+   "stdin", "stdout", "stderr", "environ", 
+   "optarg", "optind", "opterr", "optopt",
+   "program_invocation_name", "program_invocation_short_name"
+};
+
+bool isExcluded(const char *name)
+{
+   // Guard variables of function local statics and the objects they 
+   // guard. Such objects are constructed dynamically and may own
+   // heap memory.
+   //
+   if(hasPrefix(name, "_ZGV")) { return true; }
+   
+   // Reserved identifiers of the compiler and the C runtime.
+   //
+   if((name[0] == '_') && (name[1] != 'Z')) { return true; }
+   
+   for(const char *prefix: excluded_prefixes) {
+      if(hasPrefix(name, prefix)) { return true; }
+   }
+   
+   for(const char *excluded_name: excluded_names) {
+      if(strcmp(name, excluded_name) == 0) { return true; }
+   }
+   
+   return false;
+}
+
+struct Symbol 
+{
+   const char *name;
+   char *begin;
+   char *end;
+};
+
+// Reads the data objects of the executable from its symbol table
+// and returns the memory regions of those that belong to the firmware.
+//
+std::vector<FirmwareSnapshot::Region> readFirmwareRegions()
+{
+   int fd = open("/proc/self/exe", O_RDONLY);
+   if(fd < 0) {
+      KS_T_EXCEPTION("Unable to open the executable to read its symbol table")
+   }
+   
+   struct stat st;
+   if(fstat(fd, &st) != 0) {
+      close(fd);
+      KS_T_EXCEPTION("Unable to stat the executable")
+   }
+   
+   void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   
+   if(mapping == MAP_FAILED) {
+      KS_T_EXCEPTION("Unable to map the executable")
+   }
+   
+   const char *image = static_cast<const char*>(mapping);
+   const auto *header = reinterpret_cast<const ElfW(Ehdr)*>(image);
+   const auto *sections = reinterpret_cast<const ElfW(Shdr)*>(image + header->e_shoff);
+   
+   // The address the executable was loaded to, zero for executables 
+   // that are not position independent. The executable is always the
+   // first object reported.
+   //
+   uintptr_t load_address = 0;
+   dl_iterate_phdr([](struct dl_phdr_info *info, size_t, void *data) -> int {
+         *static_cast<uintptr_t*>(data) = info->dlpi_addr;
+         return 1;
+      }, &load_address);
+   
+   bool has_symbol_table = false;
+   std::vector<Symbol> symbols;
+   
+   // The objects whose initialization is guarded.
+   //
+   std::vector<std::string> guarded;
+   
+   for(int i = 0; i < header->e_shnum; ++i) {
+      
+      if(sections[i].sh_type != SHT_SYMTAB) { continue; }
+      
+      has_symbol_table = true;
+      
+      const auto *entries = reinterpret_cast<const ElfW(Sym)*>(image + sections[i].sh_offset);
+      size_t n_entries = sections[i].sh_size/sizeof(ElfW(Sym));
+      const char *names = image + sections[sections[i].sh_link].sh_offset;
+      
+      for(size_t j = 0; j < n_entries; ++j) {
+         
+         const auto &entry = entries[j];
+         
+         if(   (ELF64_ST_TYPE(entry.st_info) != STT_OBJECT)
+            || (entry.st_size == 0)) { continue; }
+         
+         char *begin = reinterpret_cast<char*>(load_address + entry.st_value);
+         char *end = begin + entry.st_size;
+         
+         if((begin < __data_start) || (end > _end)) { continue; }
+         
+         const char *name = names + entry.st_name;
+         
+         if(hasPrefix(name, "_ZGV")) {
+            guarded.push_back(std::string{"_Z"} + (name + 4));
+         }
+         
+         if(isExcluded(name)) { continue; }
+         
+         symbols.push_back(Symbol{name, begin, end});
+      }
+   }
+   
+   if(!has_symbol_table) {
+      munmap(mapping, st.st_size);
+      KS_T_EXCEPTION("Firmware snapshots require an executable with a symbol table"
+                     " (do not strip the firmware binary)")
+   }
+   
+   std::sort(guarded.begin(), guarded.end());
+   
+   symbols.erase(
+      std::remove_if(symbols.begin(), symbols.end(),
+         [&](const Symbol &symbol) {
+            return std::binary_search(guarded.begin(), guarded.end(), 
+                                      std::string{symbol.name});
+         }),
+      symbols.end());
+   
+   std::sort(symbols.begin(), symbols.end(),
+             [](const Symbol &a, const Symbol &b) { return a.begin < b.begin; });
+   
+   // Symbol names point into the mapping.
+   //
+   munmap(mapping, st.st_size);
+   
+   // Merge adjacent and aliased objects.
+   //
+   std::vector<FirmwareSnapshot::Region> regions;
+   
+   for(const auto &symbol: symbols) {
+      if(!regions.empty()) {
+         auto &last = regions.back();
+         char *last_end = last.begin + last.size;
+         if(symbol.begin <= last_end) {
+            if(symbol.end > last_end) {
+               last.size = size_t(symbol.end - last.begin);
+            }
+            continue;
+         }
+      }
+      regions.push_back(FirmwareSnapshot::Region{symbol.begin, size_t(symbol.end - symbol.begin)});
+   }
+   
+   return regions;
+}
+
+} // namespace
+
+#endif
+
+const std::vector<FirmwareSnapshot::Region> &FirmwareSnapshot::getRegions()
+{
+#ifdef __linux__
+   // The symbol table is only read once. As a static of the simulator,
+   // the object is itself excluded from snapshots.
+   //
+   static const std::vector<Region> regions = readFirmwareRegions();
+   return regions;
+#else
+   KS_T_EXCEPTION("Firmware snapshots are only supported on GNU/Linux")
+#endif
+}
+
+void FirmwareSnapshot::capture(uint32_t time)
+{
+   const auto &regions = getRegions();
+
+   size_t size = 0;
+   for(const auto &r: regions) {
+      size += r.size;
+   }
+
+   data_.resize(size);
+
+   char *dest = data_.data();
+   for(const auto &r: regions) {
+      memcpy(dest, r.begin, r.size);
+      dest += r.size;
+   }
+
+   time_ = time;
+}
+
+void FirmwareSnapshot::restore() const
+{
+   if(!this->isValid()) {
+      KS_T_EXCEPTION("Unable to restore an empty firmware snapshot")
+   }
+
+   const char *src = data_.data();
+   for(const auto &r: getRegions()) {
+      memcpy(r.begin, src, r.size);
+      src += r.size;
+   }
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,117 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief A copy of the complete state of the virtual firmware.
+/// @details The firmware (Kaleidoscope, the device with its key scanner
+///        and LED buffer, the layer stack and all plugins) keeps its
+///        entire state in static storage. A snapshot is a copy of the
+///        firmware's objects in the executable's writable data segment
+///        (.data and .bss) together with the simulated time. 
+///        Restoring a snapshot is nothing more than a memcpy per
+///        contiguous range of objects.
+///
+///        The objects are determined once from the executable's symbol
+///        table. Excluded are
+///        - the statics of the simulator, of papilio and of the 
+///          Aglais parser (namespaces kaleidoscope::simulator, 
+///          papilio and aglais),
+///        - the statics of the C++ standard library, including
+///          the standard streams,
+///        - objects of the C runtime and reserved identifiers,
+///        - function local statics that are initialized dynamically, 
+///          together with their guard variables.
+///
+///        Restrictions:
+///        - Only supported on GNU/Linux with a GNU compatible toolchain.
+///          On other platforms, capture() and restore() throw.
+///        - The executable must not be stripped.
+///        - Firmware objects that own heap memory (e.g. plugins with
+///          standard containers) must not be resized between capture 
+///          and restore, as the restore brings back their old pointers.
+///        - Snapshots are only valid within the process that created them.
+///          Never keep snapshot objects in static storage of the firmware.
+///
+class FirmwareSnapshot
+{
+   public:
+
+      /// @brief Captures the current firmware state.
+      /// @param time The simulated time to store with the snapshot.
+      ///
+      void capture(uint32_t time);
+
+      /// @brief Writes the stored state back to the firmware.
+      /// @details The simulated time is not restored. It must be
+      ///        applied by the caller.
+      ///
+      void restore() const;
+
+      /// @brief Checks if the snapshot holds data.
+      ///
+      bool isValid() const { return !data_.empty(); }
+
+      /// @brief Retreives the simulated time at which the snapshot was taken.
+      /// @returns The time in [ms].
+      ///
+      uint32_t getTime() const { return time_; }
+
+      /// @brief Retreives the amount of memory occupied by the snapshot.
+      /// @returns The size in bytes.
+      ///
+      size_t getSize() const { return data_.size(); }
+
+      /// @brief Checks if firmware snapshots are supported on the 
+      ///        current platform.
+      ///
+      static constexpr bool isSupported() {
+#ifdef __linux__
+         return true;
+#else
+         return false;
+#endif
+      }
+
+      /// @brief A contiguous range of firmware objects.
+      ///
+      struct Region {
+         char *begin;
+         size_t size;
+      };
+
+      /// @brief Access the memory ranges that are copied by a snapshot.
+      /// @details Throws if snapshots are not supported.
+      ///
+      static const std::vector<Region> &getRegions();
+
+   private:
+
+      std::vector<char> data_;
+      uint32_t time_ = 0;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
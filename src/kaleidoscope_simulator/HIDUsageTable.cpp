@@ -0,0 +1,296 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/HIDUsageTable.h"
+
+#ifdef __linux__
+#include <linux/input-event-codes.h>
+#define KS_SIM_LINUX_KEY(KEY) KEY_##KEY
+#else
+#define KS_SIM_LINUX_KEY(KEY) 0
+#endif
+
+namespace kaleidoscope {
+namespace simulator {
+   
+// The table is a constant expression. Thus, it lives in read-only
+// memory and requires no initialization at program startup.
+//
+// Columns: Kaleidoscope key name, keymap label, dump name, Linux keycode
+//
+constexpr HIDUsage hid_usage_table[256] = {
+   /* 0x00 */ { "", nullptr, "NO_EVENT", 0 },
+   /* 0x01 */ { "", nullptr, "ERROR_ROLLOVER", 0 },
+   /* 0x02 */ { "", nullptr, "POST_FAIL", 0 },
+   /* 0x03 */ { "", nullptr, "ERROR_UNDEFINED", 0 },
+   /* 0x04 */ { "A", "A   ", "a", KS_SIM_LINUX_KEY(A) },
+   /* 0x05 */ { "B", "B   ", "b", KS_SIM_LINUX_KEY(B) },
+   /* 0x06 */ { "C", "C   ", "c", KS_SIM_LINUX_KEY(C) },
+   /* 0x07 */ { "D", "D   ", "d", KS_SIM_LINUX_KEY(D) },
+   /* 0x08 */ { "E", "E   ", "e", KS_SIM_LINUX_KEY(E) },
+   /* 0x09 */ { "F", "F   ", "f", KS_SIM_LINUX_KEY(F) },
+   /* 0x0A */ { "G", "G   ", "g", KS_SIM_LINUX_KEY(G) },
+   /* 0x0B */ { "H", "H   ", "h", KS_SIM_LINUX_KEY(H) },
+   /* 0x0C */ { "I", "I   ", "i", KS_SIM_LINUX_KEY(I) },
+   /* 0x0D */ { "J", "J   ", "j", KS_SIM_LINUX_KEY(J) },
+   /* 0x0E */ { "K", "K   ", "k", KS_SIM_LINUX_KEY(K) },
+   /* 0x0F */ { "L", "L   ", "l", KS_SIM_LINUX_KEY(L) },
+   /* 0x10 */ { "M", "M   ", "m", KS_SIM_LINUX_KEY(M) },
+   /* 0x11 */ { "N", "N   ", "n", KS_SIM_LINUX_KEY(N) },
+   /* 0x12 */ { "O", "O   ", "o", KS_SIM_LINUX_KEY(O) },
+   /* 0x13 */ { "P", "P   ", "p", KS_SIM_LINUX_KEY(P) },
+   /* 0x14 */ { "Q", "Q   ", "q", KS_SIM_LINUX_KEY(Q) },
+   /* 0x15 */ { "R", "R   ", "r", KS_SIM_LINUX_KEY(R) },
+   /* 0x16 */ { "S", "S   ", "s", KS_SIM_LINUX_KEY(S) },
+   /* 0x17 */ { "T", "T   ", "t", KS_SIM_LINUX_KEY(T) },
+   /* 0x18 */ { "U", "U   ", "u", KS_SIM_LINUX_KEY(U) },
+   /* 0x19 */ { "V", "V   ", "v", KS_SIM_LINUX_KEY(V) },
+   /* 0x1A */ { "W", "W   ", "w", KS_SIM_LINUX_KEY(W) },
+   /* 0x1B */ { "X", "X   ", "x", KS_SIM_LINUX_KEY(X) },
+   /* 0x1C */ { "Y", "Y   ", "y", KS_SIM_LINUX_KEY(Y) },
+   /* 0x1D */ { "Z", "Z   ", "z", KS_SIM_LINUX_KEY(Z) },
+   /* 0x1E */ { "1", "1 ! ", "1/!", KS_SIM_LINUX_KEY(1) },
+   /* 0x1F */ { "2", "2 @ ", "2/@", KS_SIM_LINUX_KEY(2) },
+   /* 0x20 */ { "3", "3 # ", "3/#", KS_SIM_LINUX_KEY(3) },
+   /* 0x21 */ { "4", "4 $ ", "4/$", KS_SIM_LINUX_KEY(4) },
+   /* 0x22 */ { "5", "5 % ", "5/%", KS_SIM_LINUX_KEY(5) },
+   /* 0x23 */ { "6", "6 ^ ", "6/^", KS_SIM_LINUX_KEY(6) },
+   /* 0x24 */ { "7", "7 & ", "7/&", KS_SIM_LINUX_KEY(7) },
+   /* 0x25 */ { "8", "8 * ", "8/*", KS_SIM_LINUX_KEY(8) },
+   /* 0x26 */ { "9", "9 ( ", "9/(", KS_SIM_LINUX_KEY(9) },
+   /* 0x27 */ { "0", "0 ) ", "0/)", KS_SIM_LINUX_KEY(0) },
+   /* 0x28 */ { "Enter", "Entr", "enter", KS_SIM_LINUX_KEY(ENTER) },
+   /* 0x29 */ { "Escape", "Esc ", "esc", KS_SIM_LINUX_KEY(ESC) },
+   /* 0x2A */ { "Backspace", "Del ", "del/bksp", KS_SIM_LINUX_KEY(BACKSPACE) },
+   /* 0x2B */ { "Tab", "Tab ", "tab", KS_SIM_LINUX_KEY(TAB) },
+   /* 0x2C */ { "Spacebar", "Spce", "space", KS_SIM_LINUX_KEY(SPACE) },
+   /* 0x2D */ { "Minus", "- _ ", "-/_", KS_SIM_LINUX_KEY(MINUS) },
+   /* 0x2E */ { "Equals", "= + ", "=/+", KS_SIM_LINUX_KEY(EQUAL) },
+   /* 0x2F */ { "LeftBracket", "[ { ", "[/{", KS_SIM_LINUX_KEY(LEFTBRACE) },
+   /* 0x30 */ { "RightBracket", "] } ", "]/}", KS_SIM_LINUX_KEY(RIGHTBRACE) },
+   /* 0x31 */ { "Backslash", "\\ | ", "\\/|", KS_SIM_LINUX_KEY(BACKSLASH) },
+   /* 0x32 */ { "NonUsPound", "   ~ ", "#/~", KS_SIM_LINUX_KEY(BACKSLASH) },
+   /* 0x33 */ { "Semicolon", "; , ", ";/:", KS_SIM_LINUX_KEY(SEMICOLON) },
+   /* 0x34 */ { "Quote", "\' \" ", "'/\"", KS_SIM_LINUX_KEY(APOSTROPHE) },
+   /* 0x35 */ { "Backtick", "` ~ ", "`/~", KS_SIM_LINUX_KEY(GRAVE) },
+   /* 0x36 */ { "Comma", ", < ", ",/<", KS_SIM_LINUX_KEY(COMMA) },
+   /* 0x37 */ { "Period", ". > ", "./>", KS_SIM_LINUX_KEY(DOT) },
+   /* 0x38 */ { "Slash", "/ ? ", "//?", KS_SIM_LINUX_KEY(SLASH) },
+   /* 0x39 */ { "CapsLock", "C.L.", "capslock", KS_SIM_LINUX_KEY(CAPSLOCK) },
+   /* 0x3A */ { "F1", "F1  ", "F1", KS_SIM_LINUX_KEY(F1) },
+   /* 0x3B */ { "F2", "F2  ", "F2", KS_SIM_LINUX_KEY(F2) },
+   /* 0x3C */ { "F3", "F3  ", "F3", KS_SIM_LINUX_KEY(F3) },
+   /* 0x3D */ { "F4", "F4  ", "F4", KS_SIM_LINUX_KEY(F4) },
+   /* 0x3E */ { "F5", "F5  ", "F5", KS_SIM_LINUX_KEY(F5) },
+   /* 0x3F */ { "F6", "F6  ", "F6", KS_SIM_LINUX_KEY(F6) },
+   /* 0x40 */ { "F7", "F7  ", "F7", KS_SIM_LINUX_KEY(F7) },
+   /* 0x41 */ { "F8", "F8  ", "F8", KS_SIM_LINUX_KEY(F8) },
+   /* 0x42 */ { "F9", "F9  ", "F9", KS_SIM_LINUX_KEY(F9) },
+   /* 0x43 */ { "F10", "F10 ", "F10", KS_SIM_LINUX_KEY(F10) },
+   /* 0x44 */ { "F11", "F11 ", "F11", KS_SIM_LINUX_KEY(F11) },
+   /* 0x45 */ { "F12", "F12 ", "F12", KS_SIM_LINUX_KEY(F12) },
+   /* 0x46 */ { "PrintScreen", "PRTS", "prtscr", KS_SIM_LINUX_KEY(SYSRQ) },
+   /* 0x47 */ { "ScrollLock", "ScLk", "scrolllock", KS_SIM_LINUX_KEY(SCROLLLOCK) },
+   /* 0x48 */ { "Pause", "Pse ", "pause", KS_SIM_LINUX_KEY(PAUSE) },
+   /* 0x49 */ { "Insert", "Isrt", "ins", KS_SIM_LINUX_KEY(INSERT) },
+   /* 0x4A */ { "Home", "Home", "home", KS_SIM_LINUX_KEY(HOME) },
+   /* 0x4B */ { "PageUp", "PgUp", "pgup", KS_SIM_LINUX_KEY(PAGEUP) },
+   /* 0x4C */ { "Delete", "Del ", "del", KS_SIM_LINUX_KEY(DELETE) },
+   /* 0x4D */ { "End", "End ", "end", KS_SIM_LINUX_KEY(END) },
+   /* 0x4E */ { "PageDown", "PgDn", "pgdn", KS_SIM_LINUX_KEY(PAGEDOWN) },
+   /* 0x4F */ { "RightArrow", "→   ", "r_arrow", KS_SIM_LINUX_KEY(RIGHT) },
+   /* 0x50 */ { "LeftArrow", "←   ", "l_arrow", KS_SIM_LINUX_KEY(LEFT) },
+   /* 0x51 */ { "DownArrow", "↓   ", "d_arrow", KS_SIM_LINUX_KEY(DOWN) },
+   /* 0x52 */ { "UpArrow", "↑   ", "u_arrow", KS_SIM_LINUX_KEY(UP) },
+   /* 0x53 */ { "KeypadNumLock", "NlCl", "numlock", KS_SIM_LINUX_KEY(NUMLOCK) },
+   /* 0x54 */ { "KeypadDivide", "/   ", "num/", KS_SIM_LINUX_KEY(KPSLASH) },
+   /* 0x55 */ { "KeypadMultiply", "*   ", "num*", KS_SIM_LINUX_KEY(KPASTERISK) },
+   /* 0x56 */ { "KeypadSubtract", "-   ", "num-", KS_SIM_LINUX_KEY(KPMINUS) },
+   /* 0x57 */ { "KeypadAdd", "+   ", "num+", KS_SIM_LINUX_KEY(KPPLUS) },
+   /* 0x58 */ { "KeypadEnter", "Entr", "numenter", KS_SIM_LINUX_KEY(KPENTER) },
+   /* 0x59 */ { "Keypad1", "1 Ed", "num1", KS_SIM_LINUX_KEY(KP1) },
+   /* 0x5A */ { "Keypad2", "2 ↓ ", "num2", KS_SIM_LINUX_KEY(KP2) },
+   /* 0x5B */ { "Keypad3", "3 PD", "num3", KS_SIM_LINUX_KEY(KP3) },
+   /* 0x5C */ { "Keypad4", "4 ← ", "num4", KS_SIM_LINUX_KEY(KP4) },
+   /* 0x5D */ { "Keypad5", "5   ", "num5", KS_SIM_LINUX_KEY(KP5) },
+   /* 0x5E */ { "Keypad6", "6 → ", "num6", KS_SIM_LINUX_KEY(KP6) },
+   /* 0x5F */ { "Keypad7", "7 Hm", "num7", KS_SIM_LINUX_KEY(KP7) },
+   /* 0x60 */ { "Keypad8", "8 ↑ ", "num8", KS_SIM_LINUX_KEY(KP8) },
+   /* 0x61 */ { "Keypad9", "9 PU", "num9", KS_SIM_LINUX_KEY(KP9) },
+   /* 0x62 */ { "Keypad0", "0 IN", "num0", KS_SIM_LINUX_KEY(KP0) },
+   /* 0x63 */ { "KeypadDot", ". DL", "num.", KS_SIM_LINUX_KEY(KPDOT) },
+   /* 0x64 */ { "NonUsBackslashAndPipe", "\\ | ", "\\/|", KS_SIM_LINUX_KEY(SLASH) },
+   /* 0x65 */ { "PcApplication", nullptr, "app", KS_SIM_LINUX_KEY(APPSELECT) },
+   /* 0x66 */ { "Power", nullptr, "power", KS_SIM_LINUX_KEY(POWER) },
+   /* 0x67 */ { "KeypadEquals", "=   ", "num=", KS_SIM_LINUX_KEY(KPEQUAL) },
+   /* 0x68 */ { "F13", "F13 ", "F13", KS_SIM_LINUX_KEY(F13) },
+   /* 0x69 */ { "F14", "F14 ", "F14", KS_SIM_LINUX_KEY(F14) },
+   /* 0x6A */ { "F15", "F15 ", "F15", KS_SIM_LINUX_KEY(F15) },
+   /* 0x6B */ { "F16", "F16 ", "F16", KS_SIM_LINUX_KEY(F16) },
+   /* 0x6C */ { "F17", "F17 ", "F17", KS_SIM_LINUX_KEY(F17) },
+   /* 0x6D */ { "F18", "F18 ", "F18", KS_SIM_LINUX_KEY(F18) },
+   /* 0x6E */ { "F19", "F19 ", "F19", KS_SIM_LINUX_KEY(F19) },
+   /* 0x6F */ { "F20", "F20 ", "F20", KS_SIM_LINUX_KEY(F20) },
+   /* 0x70 */ { "F21", "F21 ", "F21", KS_SIM_LINUX_KEY(F21) },
+   /* 0x71 */ { "F22", "F22 ", "F22", KS_SIM_LINUX_KEY(F22) },
+   /* 0x72 */ { "F23", "F23 ", "F23", KS_SIM_LINUX_KEY(F23) },
+   /* 0x73 */ { "F24", "F24 ", "F24", KS_SIM_LINUX_KEY(F24) },
+   /* 0x74 */ { "Execute", nullptr, "exec", KS_SIM_LINUX_KEY(OPEN) },
+   /* 0x75 */ { "Help", nullptr, "help", KS_SIM_LINUX_KEY(HELP) },
+   /* 0x76 */ { "Menu", nullptr, "menu", KS_SIM_LINUX_KEY(MENU) },
+   /* 0x77 */ { "Select", nullptr, "sel", KS_SIM_LINUX_KEY(SELECT) },
+   /* 0x78 */ { "Stop", nullptr, "stop", KS_SIM_LINUX_KEY(STOP) },
+   /* 0x79 */ { "Again", nullptr, "again", KS_SIM_LINUX_KEY(AGAIN) },
+   /* 0x7A */ { "Undo", nullptr, "undo", KS_SIM_LINUX_KEY(UNDO) },
+   /* 0x7B */ { "Cut", nullptr, "cut", KS_SIM_LINUX_KEY(CUT) },
+   /* 0x7C */ { "Copy", nullptr, "copy", KS_SIM_LINUX_KEY(COPY) },
+   /* 0x7D */ { "Paste", nullptr, "paste", KS_SIM_LINUX_KEY(PASTE) },
+   /* 0x7E */ { "Find", nullptr, "find", KS_SIM_LINUX_KEY(FIND) },
+   /* 0x7F */ { "Mute", nullptr, "mute", KS_SIM_LINUX_KEY(MUTE) },
+   /* 0x80 */ { "VolumeUp", nullptr, "volup", KS_SIM_LINUX_KEY(VOLUMEUP) },
+   /* 0x81 */ { "VolumeDown", nullptr, "voldn", KS_SIM_LINUX_KEY(VOLUMEDOWN) },
+   /* 0x82 */ { "LockingCapsLock", nullptr, "capslock_l", KS_SIM_LINUX_KEY(UNKNOWN) },
+   /* 0x83 */ { "LockingNumLock", nullptr, "numlock_l", KS_SIM_LINUX_KEY(UNKNOWN) },
+   /* 0x84 */ { "LockingScrollLock", nullptr, "scrolllock_l", KS_SIM_LINUX_KEY(UNKNOWN) },
+   /* 0x85 */ { "KeypadComma", ",   ", "num,", KS_SIM_LINUX_KEY(UNKNOWN) },
+   /* 0x86 */ { "KeypadEqualSign", "=   ", "num=", KS_SIM_LINUX_KEY(UNKNOWN) },
+   /* 0x87 */ { "International1", nullptr, nullptr, KS_SIM_LINUX_KEY(UNKNOWN) },
+   /* 0x88 */ { "International2", nullptr, nullptr, 0 },
+   /* 0x89 */ { "International3", nullptr, nullptr, 0 },
+   /* 0x8A */ { "International4", nullptr, nullptr, 0 },
+   /* 0x8B */ { "International5", nullptr, nullptr, 0 },
+   /* 0x8C */ { "International6", nullptr, nullptr, 0 },
+   /* 0x8D */ { "International7", nullptr, nullptr, 0 },
+   /* 0x8E */ { "International8", nullptr, nullptr, 0 },
+   /* 0x8F */ { "International9", nullptr, nullptr, 0 },
+   /* 0x90 */ { "Lang1", nullptr, nullptr, 0 },
+   /* 0x91 */ { "Lang2", nullptr, nullptr, 0 },
+   /* 0x92 */ { "Lang3", nullptr, nullptr, 0 },
+   /* 0x93 */ { "Lang4", nullptr, nullptr, 0 },
+   /* 0x94 */ { "Lang5", nullptr, nullptr, 0 },
+   /* 0x95 */ { "Lang6", nullptr, nullptr, 0 },
+   /* 0x96 */ { "Lang7", nullptr, nullptr, 0 },
+   /* 0x97 */ { "Lang8", nullptr, nullptr, 0 },
+   /* 0x98 */ { "Lang9", nullptr, nullptr, 0 },
+   /* 0x99 */ { "AlternateErase", nullptr, nullptr, 0 },
+   /* 0x9A */ { "Sysreq", nullptr, nullptr, 0 },
+   /* 0x9B */ { "Cancel", nullptr, nullptr, 0 },
+   /* 0x9C */ { "Clear", nullptr, nullptr, 0 },
+   /* 0x9D */ { "Prior", nullptr, nullptr, 0 },
+   /* 0x9E */ { "Return", nullptr, nullptr, 0 },
+   /* 0x9F */ { "Separator", nullptr, nullptr, 0 },
+   /* 0xA0 */ { "Out", nullptr, nullptr, 0 },
+   /* 0xA1 */ { "Oper", nullptr, nullptr, 0 },
+   /* 0xA2 */ { "ClearSlashAgain", nullptr, nullptr, 0 },
+   /* 0xA3 */ { "CrselSlashProps", nullptr, nullptr, 0 },
+   /* 0xA4 */ { "Exsel", nullptr, nullptr, 0 },
+   /* 0xA5 */ { "", nullptr, nullptr, 0 },
+   /* 0xA6 */ { "", nullptr, nullptr, 0 },
+   /* 0xA7 */ { "", nullptr, nullptr, 0 },
+   /* 0xA8 */ { "", nullptr, nullptr, 0 },
+   /* 0xA9 */ { "", nullptr, nullptr, 0 },
+   /* 0xAA */ { "", nullptr, nullptr, 0 },
+   /* 0xAB */ { "", nullptr, nullptr, 0 },
+   /* 0xAC */ { "", nullptr, nullptr, 0 },
+   /* 0xAD */ { "", nullptr, nullptr, 0 },
+   /* 0xAE */ { "", nullptr, nullptr, 0 },
+   /* 0xAF */ { "", nullptr, nullptr, 0 },
+   /* 0xB0 */ { "Keypad00", nullptr, nullptr, 0 },
+   /* 0xB1 */ { "Keypad000", nullptr, nullptr, 0 },
+   /* 0xB2 */ { "ThousandsSeparator", nullptr, nullptr, 0 },
+   /* 0xB3 */ { "DecimalSeparator", nullptr, nullptr, 0 },
+   /* 0xB4 */ { "CurrencyUnit", nullptr, nullptr, 0 },
+   /* 0xB5 */ { "CurrencySubunit", nullptr, nullptr, 0 },
+   /* 0xB6 */ { "KeypadLeftParen", nullptr, nullptr, 0 },
+   /* 0xB7 */ { "KeypadRightParen", nullptr, nullptr, 0 },
+   /* 0xB8 */ { "KeypadLeftCurlyBrace", nullptr, nullptr, 0 },
+   /* 0xB9 */ { "KeypadRightCurlyBrace", nullptr, nullptr, 0 },
+   /* 0xBA */ { "KeypadTab", nullptr, nullptr, 0 },
+   /* 0xBB */ { "KeypadBackspace", nullptr, nullptr, 0 },
+   /* 0xBC */ { "KeypadA", nullptr, nullptr, 0 },
+   /* 0xBD */ { "KeypadB", nullptr, nullptr, 0 },
+   /* 0xBE */ { "KeypadC", nullptr, nullptr, 0 },
+   /* 0xBF */ { "KeypadD", nullptr, nullptr, 0 },
+   /* 0xC0 */ { "KeypadE", nullptr, nullptr, 0 },
+   /* 0xC1 */ { "KeypadF", nullptr, nullptr, 0 },
+   /* 0xC2 */ { "KeypadXor", nullptr, nullptr, 0 },
+   /* 0xC3 */ { "KeypadCarat", nullptr, nullptr, 0 },
+   /* 0xC4 */ { "KeypadPercent", nullptr, nullptr, 0 },
+   /* 0xC5 */ { "KeypadLessThan", nullptr, nullptr, 0 },
+   /* 0xC6 */ { "KeypadGreaterThan", nullptr, nullptr, 0 },
+   /* 0xC7 */ { "KeypadAmpersand", nullptr, nullptr, 0 },
+   /* 0xC8 */ { "KeypadDoubleampersand", nullptr, nullptr, 0 },
+   /* 0xC9 */ { "KeypadPipe", nullptr, nullptr, 0 },
+   /* 0xCA */ { "KeypadDoublepipe", nullptr, nullptr, 0 },
+   /* 0xCB */ { "KeypadColon", nullptr, nullptr, 0 },
+   /* 0xCC */ { "KeypadPoundSign", nullptr, nullptr, 0 },
+   /* 0xCD */ { "KeypadSpace", nullptr, nullptr, 0 },
+   /* 0xCE */ { "KeypadAtSign", nullptr, nullptr, 0 },
+   /* 0xCF */ { "KeypadExclamationPoint", nullptr, nullptr, 0 },
+   /* 0xD0 */ { "KeypadMemoryStore", nullptr, nullptr, 0 },
+   /* 0xD1 */ { "KeypadMemoryRecall", nullptr, nullptr, 0 },
+   /* 0xD2 */ { "KeypadMemoryClear", nullptr, nullptr, 0 },
+   /* 0xD3 */ { "KeypadMemoryAdd", nullptr, nullptr, 0 },
+   /* 0xD4 */ { "KeypadMemorySubtract", nullptr, nullptr, 0 },
+   /* 0xD5 */ { "KeypadMemoryMultiply", nullptr, nullptr, 0 },
+   /* 0xD6 */ { "KeypadMemoryDivide", nullptr, nullptr, 0 },
+   /* 0xD7 */ { "KeypadPlusSlashMinus", nullptr, nullptr, 0 },
+   /* 0xD8 */ { "KeypadClear", nullptr, nullptr, 0 },
+   /* 0xD9 */ { "KeypadClearEntry", nullptr, nullptr, 0 },
+   /* 0xDA */ { "KeypadBinary", nullptr, nullptr, 0 },
+   /* 0xDB */ { "KeypadOctal", nullptr, nullptr, 0 },
+   /* 0xDC */ { "KeypadDecimal", nullptr, nullptr, 0 },
+   /* 0xDD */ { "KeypadHexadecimal", nullptr, nullptr, 0 },
+   /* 0xDE */ { "", nullptr, nullptr, 0 },
+   /* 0xDF */ { "", nullptr, nullptr, 0 },
+   /* 0xE0 */ { "LeftControl", nullptr, "lctrl", KS_SIM_LINUX_KEY(LEFTCTRL) },
+   /* 0xE1 */ { "LeftShift", nullptr, "lshift", KS_SIM_LINUX_KEY(LEFTSHIFT) },
+   /* 0xE2 */ { "LeftAlt", nullptr, "lalt", KS_SIM_LINUX_KEY(LEFTALT) },
+   /* 0xE3 */ { "LeftGui", nullptr, "lgui", KS_SIM_LINUX_KEY(LEFTMETA) },
+   /* 0xE4 */ { "RightControl", nullptr, "rctrl", KS_SIM_LINUX_KEY(RIGHTCTRL) },
+   /* 0xE5 */ { "RightShift", nullptr, "rshift", KS_SIM_LINUX_KEY(RIGHTSHIFT) },
+   /* 0xE6 */ { "RightAlt", nullptr, "ralt", KS_SIM_LINUX_KEY(RIGHTALT) },
+   /* 0xE7 */ { "RightGui", nullptr, "rgui", KS_SIM_LINUX_KEY(RIGHTMETA) },
+   /* 0xE8 */ { "", nullptr, nullptr, 0 },
+   /* 0xE9 */ { "", nullptr, nullptr, 0 },
+   /* 0xEA */ { "", nullptr, nullptr, 0 },
+   /* 0xEB */ { "", nullptr, nullptr, 0 },
+   /* 0xEC */ { "", nullptr, nullptr, 0 },
+   /* 0xED */ { "", nullptr, nullptr, 0 },
+   /* 0xEE */ { "", nullptr, nullptr, 0 },
+   /* 0xEF */ { "", nullptr, nullptr, 0 },
+   /* 0xF0 */ { "", nullptr, nullptr, 0 },
+   /* 0xF1 */ { "", nullptr, nullptr, 0 },
+   /* 0xF2 */ { "", nullptr, nullptr, 0 },
+   /* 0xF3 */ { "", nullptr, nullptr, 0 },
+   /* 0xF4 */ { "", nullptr, nullptr, 0 },
+   /* 0xF5 */ { "", nullptr, nullptr, 0 },
+   /* 0xF6 */ { "", nullptr, nullptr, 0 },
+   /* 0xF7 */ { "", nullptr, nullptr, 0 },
+   /* 0xF8 */ { "", nullptr, nullptr, 0 },
+   /* 0xF9 */ { "", nullptr, nullptr, 0 },
+   /* 0xFA */ { "", nullptr, nullptr, 0 },
+   /* 0xFB */ { "", nullptr, nullptr, 0 },
+   /* 0xFC */ { "", nullptr, nullptr, 0 },
+   /* 0xFD */ { "", nullptr, nullptr, 0 },
+   /* 0xFE */ { "", nullptr, nullptr, 0 },
+   /* 0xFF */ { "", nullptr, nullptr, 0 }
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,64 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief Information about a usage of the HID keyboard/keypad page.
+///
+struct HIDUsage {
+   
+   /// @brief The name of the Kaleidoscope key (without Key_ prefix)
+   ///        or an empty string if there is no such key.
+   ///
+   const char *name;
+   
+   /// @brief A four character label used to visualize keymaps or
+   ///        nullptr if there is none.
+   ///
+   const char *label;
+   
+   /// @brief A short name used in report dumps or nullptr if there is none.
+   ///
+   const char *dump_name;
+   
+   /// @brief The Linux input event code (see linux/input-event-codes.h)
+   ///        or zero if there is none. Always zero on platforms other 
+   ///        than Linux.
+   ///
+   uint16_t linux_keycode;
+};
+
+/// @brief Information about all keyboard usages, indexed by usage id 
+///        (keycode).
+///
+extern const HIDUsage hid_usage_table[256];
+
+/// @brief Access information about a keyboard usage.
+/// @param keycode The usage id.
+///
+inline const HIDUsage &getHIDUsage(uint8_t keycode) {
+   return hid_usage_table[keycode];
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,132 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/HookProfiler.h"
+#include "papilio/Simulator.h"
+
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+
+namespace kaleidoscope {
+namespace simulator {
+
+namespace {
+
+std::atomic<uint64_t> last_generation{0};
+
+} // namespace
+
+   HookProfiler
+      ::HookProfiler()
+   :  generation_(++last_generation)
+{
+}
+
+const char *HookProfiler::getHookName(Hook hook)
+{
+   switch(hook) {
+      case on_setup:               return "onSetup";
+      case before_each_cycle:      return "beforeEachCycle";
+      case on_keyswitch_event:     return "onKeyswitchEvent";
+      case on_focus_event:         return "onFocusEvent";
+      case on_name_query:          return "onNameQuery";
+      case on_layer_change:        return "onLayerChange";
+      case on_led_mode_change:     return "onLEDModeChange";
+      case before_syncing_leds:    return "beforeSyncingLeds";
+      case before_reporting_state: return "beforeReportingState";
+      case after_each_cycle:       return "afterEachCycle";
+      default:                     break;
+   }
+   return "";
+}
+
+uint16_t HookProfiler::registerPlugin(const char *name)
+{
+   for(size_t i = 0; i < plugin_names_.size(); ++i) {
+      if(strcmp(plugin_names_[i], name) == 0) {
+         return uint16_t(i);
+      }
+   }
+   
+   plugin_names_.push_back(name);
+   entries_.resize(plugin_names_.size()*n_hooks);
+   
+   return uint16_t(plugin_names_.size() - 1);
+}
+
+uint64_t HookProfiler::getNumHookCalls(const char *name, Hook hook) const
+{
+   for(size_t i = 0; i < plugin_names_.size(); ++i) {
+      if(strcmp(plugin_names_[i], name) == 0) {
+         return entries_[i*n_hooks + hook].calls;
+      }
+   }
+   return 0;
+}
+
+void HookProfiler::reset()
+{
+   for(auto &entry: entries_) {
+      entry = Entry{};
+   }
+   loop_ns_ = 0;
+   n_loops_ = 0;
+}
+
+void HookProfiler::logResults(const papilio::Simulator &simulator) const
+{
+   struct Row {
+      const char *plugin;
+      const char *hook;
+      const Entry *entry;
+   };
+   
+   std::vector<Row> rows;
+   uint64_t hooks_ns = 0;
+   
+   for(size_t p = 0; p < plugin_names_.size(); ++p) {
+      for(int h = 0; h < n_hooks; ++h) {
+         const auto &entry = entries_[p*n_hooks + h];
+         if(entry.calls == 0) { continue; }
+         rows.push_back(Row{plugin_names_[p], getHookName(Hook(h)), &entry});
+         hooks_ns += entry.ns;
+      }
+   }
+   
+   std::sort(rows.begin(), rows.end(),
+      [](const Row &a, const Row &b) { return a.entry->ns > b.entry->ns; });
+   
+   simulator.log() << "Plugin hook profile (" << n_loops_ << " loops, " 
+      << loop_ns_*1e-6 << " ms in loop, " << hooks_ns*1e-6 << " ms in profiled hooks)";
+   simulator.log() << "   rank plugin hook calls total[ms] per call[ns] loop share[%]";
+      
+   int rank = 1;
+   for(const auto &row: rows) {
+      double share = (loop_ns_ > 0) ? 100.0*row.entry->ns/loop_ns_ : 0.0;
+      simulator.log() << "   " << rank << ' ' << row.plugin << ' ' << row.hook << ' '
+         << row.entry->calls << ' ' 
+         << row.entry->ns*1e-6 << ' '
+         << double(row.entry->ns)/row.entry->calls << ' '
+         << share;
+      ++rank;
+   }
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,143 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <assert.h>
+#include <vector>
+
+namespace papilio {
+class Simulator;
+} // namespace papilio
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief Collects time and call counts of plugin hooks.
+/// @details The profiler aggregates the wall clock time spent in every
+///        hook of every profiled plugin. Plugins are profiled by 
+///        registering a ProfiledPlugin proxy instead of the plugin itself
+///        with KALEIDOSCOPE_INIT_PLUGINS(...), see ProfiledPlugin.h.
+///
+class HookProfiler
+{
+   public:
+
+      /// @brief The plugin hooks that are profiled.
+      ///
+      enum Hook {
+         on_setup,
+         before_each_cycle,
+         on_keyswitch_event,
+         on_focus_event,
+         on_name_query,
+         on_layer_change,
+         on_led_mode_change,
+         before_syncing_leds,
+         before_reporting_state,
+         after_each_cycle,
+         n_hooks
+      };
+
+      /// @brief Constructor.
+      ///
+      HookProfiler();
+
+      /// @brief Retreives the name of a hook.
+      ///
+      static const char *getHookName(Hook hook);
+
+      /// @brief Enables or disables profiling.
+      ///
+      void setEnabled(bool state) { enabled_ = state; }
+
+      /// @brief Queries whether profiling is enabled.
+      ///
+      bool isEnabled() const { return enabled_; }
+
+      /// @brief Registers a plugin.
+      /// @details Registering the same name twice returns the same id.
+      /// @param name The name of the plugin.
+      /// @returns The plugin's id.
+      ///
+      uint16_t registerPlugin(const char *name);
+
+      /// @brief Retreives the generation of the profiler.
+      /// @details Every profiler object has a unique generation.
+      ///        Plugin ids are only valid for the profiler 
+      ///        of the generation they were registered with.
+      ///
+      uint64_t getGeneration() const { return generation_; }
+
+      /// @brief Retreives the number of recorded calls of a plugin's hook.
+      /// @param name The name of the plugin.
+      /// @param hook The hook.
+      /// @returns The number of calls, zero for unknown plugins.
+      ///
+      uint64_t getNumHookCalls(const char *name, Hook hook) const;
+
+      /// @brief Records a single hook call.
+      /// @param plugin_id The id of the plugin.
+      /// @param hook The hook that was called.
+      /// @param ns The duration of the call in nanoseconds.
+      ///
+      void recordHookCall(uint16_t plugin_id, Hook hook, uint64_t ns) {
+         assert(plugin_id < plugin_names_.size());
+         assert(hook < n_hooks);
+         auto &entry = entries_[plugin_id*n_hooks + hook];
+         entry.ns += ns;
+         ++entry.calls;
+      }
+
+      /// @brief Records a single firmware loop.
+      /// @param ns The duration of the loop in nanoseconds.
+      ///
+      void recordLoop(uint64_t ns) {
+         loop_ns_ += ns;
+         ++n_loops_;
+      }
+
+      /// @brief Discards all recorded data.
+      /// @details Registered plugins and their ids are kept.
+      ///
+      void reset();
+
+      /// @brief Writes a table of all plugin hooks, ranked by the
+      ///        overall time spent, to the simulator's log.
+      /// @param simulator The simulator to log with.
+      ///
+      void logResults(const papilio::Simulator &simulator) const;
+
+   private:
+
+      struct Entry {
+         uint64_t ns = 0;
+         uint64_t calls = 0;
+      };
+
+      uint64_t generation_;
+      bool enabled_ = false;
+      std::vector<const char *> plugin_names_;
+      std::vector<Entry> entries_;
+      uint64_t loop_ns_ = 0;
+      uint64_t n_loops_ = 0;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
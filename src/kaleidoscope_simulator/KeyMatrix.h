@@ -0,0 +1,155 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "Kaleidoscope.h"
+
+// Undefine some macros defined by Arduino
+//
+#undef min
+#undef max
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief A bitmap with one bit for every key of the keyboard matrix.
+/// @details The bit of a key is at position row*cols + col.
+///
+class KeyMatrix
+{
+   public:
+
+      static constexpr uint8_t rows = kaleidoscope::Device::KeyScanner::matrix_rows;
+      static constexpr uint8_t cols = kaleidoscope::Device::KeyScanner::matrix_columns;
+      static constexpr uint16_t n_keys = uint16_t(rows)*cols;
+      static constexpr uint8_t n_words = (n_keys + 63)/64;
+
+      /// @brief Default constructor.
+      /// @details Creates a matrix with no bits set.
+      ///
+      KeyMatrix() : words_{} {}
+
+      /// @brief Sets or resets the bit of a key.
+      /// @param row The key's row.
+      /// @param col The key's column.
+      /// @param state The new state of the bit.
+      ///
+      void set(uint8_t row, uint8_t col, bool state = true) {
+         uint16_t i = index(row, col);
+         uint64_t mask = uint64_t(1) << (i % 64);
+         if(state) {
+            words_[i/64] |= mask;
+         }
+         else {
+            words_[i/64] &= ~mask;
+         }
+      }
+
+      /// @brief Checks the bit of a key.
+      /// @param row The key's row.
+      /// @param col The key's column.
+      /// @returns True if the key's bit is set.
+      ///
+      bool test(uint8_t row, uint8_t col) const {
+         uint16_t i = index(row, col);
+         return (words_[i/64] >> (i % 64)) & 1;
+      }
+
+      /// @brief Resets all bits.
+      ///
+      void clear() {
+         for(uint8_t w = 0; w < n_words; ++w) { words_[w] = 0; }
+      }
+
+      /// @brief Checks if any bit is set.
+      ///
+      bool any() const {
+         uint64_t acc = 0;
+         for(uint8_t w = 0; w < n_words; ++w) { acc |= words_[w]; }
+         return acc != 0;
+      }
+
+      /// @brief Retreives the number of bits set.
+      ///
+      uint16_t count() const {
+         uint16_t n = 0;
+         for(uint8_t w = 0; w < n_words; ++w) { n += __builtin_popcountll(words_[w]); }
+         return n;
+      }
+
+      /// @brief Calls a function for every key whose bit is set.
+      /// @param f A callable with signature void(uint8_t row, uint8_t col).
+      ///
+      template<typename _Func>
+      void forEach(_Func f) const {
+         for(uint8_t w = 0; w < n_words; ++w) {
+            uint64_t word = words_[w];
+            while(word) {
+               uint16_t i = uint16_t(w)*64 + __builtin_ctzll(word);
+               f(uint8_t(i / cols), uint8_t(i % cols));
+               word &= word - 1;
+            }
+         }
+      }
+
+      /// @brief Access the raw 64 bit words of the bitmap.
+      ///
+      uint64_t getWord(uint8_t w) const { return words_[w]; }
+      void setWord(uint8_t w, uint64_t word) { words_[w] = word; }
+
+      KeyMatrix &operator^=(const KeyMatrix &other) {
+         for(uint8_t w = 0; w < n_words; ++w) { words_[w] ^= other.words_[w]; }
+         return *this;
+      }
+      KeyMatrix &operator|=(const KeyMatrix &other) {
+         for(uint8_t w = 0; w < n_words; ++w) { words_[w] |= other.words_[w]; }
+         return *this;
+      }
+      KeyMatrix &operator&=(const KeyMatrix &other) {
+         for(uint8_t w = 0; w < n_words; ++w) { words_[w] &= other.words_[w]; }
+         return *this;
+      }
+
+      friend KeyMatrix operator^(KeyMatrix a, const KeyMatrix &b) { return a ^= b; }
+      friend KeyMatrix operator|(KeyMatrix a, const KeyMatrix &b) { return a |= b; }
+      friend KeyMatrix operator&(KeyMatrix a, const KeyMatrix &b) { return a &= b; }
+
+      bool operator==(const KeyMatrix &other) const {
+         for(uint8_t w = 0; w < n_words; ++w) {
+            if(words_[w] != other.words_[w]) { return false; }
+         }
+         return true;
+      }
+      bool operator!=(const KeyMatrix &other) const { return !(*this == other); }
+
+   private:
+
+      static uint16_t index(uint8_t row, uint8_t col) {
+         return uint16_t(row)*cols + col;
+      }
+
+   private:
+
+      uint64_t words_[n_words];
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
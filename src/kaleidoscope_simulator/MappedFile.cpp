@@ -0,0 +1,118 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/MappedFile.h"
+#include "kaleidoscope_simulator/aux/exceptions.h"
+
+#ifdef __unix__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#else
+#include <fstream>
+#include <sstream>
+#endif
+
+namespace kaleidoscope {
+namespace simulator {
+   
+#ifdef __unix__
+
+   MappedFile
+      ::MappedFile(const char *path)
+{
+   int fd = ::open(path, O_RDONLY);
+   if(fd < 0) {
+      KS_T_EXCEPTION("Unable to open file \'" << path << "\': " << strerror(errno))
+   }
+   
+   struct stat st;
+   if(fstat(fd, &st) != 0) {
+      int error = errno;
+      ::close(fd);
+      KS_T_EXCEPTION("Unable to stat file \'" << path << "\': " << strerror(error))
+   }
+   
+   size_ = st.st_size;
+   
+   // Empty files can not be mapped.
+   //
+   if(size_ == 0) {
+      ::close(fd);
+      data_ = "";
+      return;
+   }
+   
+   void *addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+   int error = errno;
+   
+   // The mapping remains valid after the file is closed.
+   //
+   ::close(fd);
+   
+   if(addr == MAP_FAILED) {
+      KS_T_EXCEPTION("Unable to map file \'" << path << "\': " << strerror(error))
+   }
+   
+   // Files are generally read front to back. This allows the 
+   // kernel to read ahead aggressively.
+   //
+   madvise(addr, size_, MADV_SEQUENTIAL);
+   
+   data_ = static_cast<const char*>(addr);
+   mapped_ = true;
+}
+
+   MappedFile
+      ::~MappedFile()
+{
+   if(mapped_) {
+      munmap(const_cast<char*>(data_), size_);
+   }
+}
+
+#else
+
+   MappedFile
+      ::MappedFile(const char *path)
+{
+   std::ifstream in(path, std::ios::binary);
+   if(!in) {
+      KS_T_EXCEPTION("Unable to open file \'" << path << "\'")
+   }
+   
+   std::ostringstream content;
+   content << in.rdbuf();
+   content_ = content.str();
+   
+   data_ = content_.data();
+   size_ = content_.size();
+}
+
+   MappedFile
+      ::~MappedFile()
+{
+}
+
+#endif
+
+} // namespace simulator
+} // namespace kaleidoscope
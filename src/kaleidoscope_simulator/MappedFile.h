@@ -0,0 +1,66 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief A file that is mapped read-only into memory.
+/// @details The file's content is paged in on demand by the operating 
+///        system. Mapping even very large files is thus cheap and
+///        independent of their size. On platforms without mmap the
+///        file is read into memory.
+///
+class MappedFile
+{
+   public:
+      
+      /// @brief Maps a file.
+      /// @details Throws if the file can not be opened or mapped.
+      /// @param path The path of the file.
+      ///
+      explicit MappedFile(const char *path);
+      
+      ~MappedFile();
+      
+      MappedFile(const MappedFile &) = delete;
+      MappedFile &operator=(const MappedFile &) = delete;
+      
+      /// @brief Access the file's content.
+      ///
+      const char *getData() const { return data_; }
+      
+      /// @brief Retreives the size of the file.
+      /// @returns The size in bytes.
+      ///
+      size_t getSize() const { return size_; }
+      
+   private:
+      
+      const char *data_ = nullptr;
+      size_t size_ = 0;
+      bool mapped_ = false;
+      std::string content_;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
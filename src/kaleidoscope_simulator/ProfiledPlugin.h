@@ -0,0 +1,182 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Kaleidoscope.h"
+#include "kaleidoscope_simulator/SimulatorCore.h"
+#include "kaleidoscope_simulator/HookProfiler.h"
+
+#include <chrono>
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief A proxy that measures the cost of the hooks of a plugin.
+/// @details Register the proxy instead of the plugin with 
+///        KALEIDOSCOPE_INIT_PLUGINS(...). Every hook call is forwarded to 
+///        the plugin and, while profiling is enabled, timed and recorded
+///        by the HookProfiler of the active simulator core. While
+///        a trace is recorded, every call also appears as a span 
+///        in the trace.
+///
+///        As the simulator is only available in virtual builds, use
+///        the proxy as follows.
+///
+/// @code
+/// #ifdef KALEIDOSCOPE_VIRTUAL_BUILD
+/// #include "kaleidoscope_simulator/ProfiledPlugin.h"
+/// KALEIDOSCOPE_SIMULATOR_PROFILED_PLUGIN(Qukeys)
+/// #define QUKEYS_PLUGIN profiled_Qukeys
+/// #else
+/// #define QUKEYS_PLUGIN Qukeys
+/// #endif
+///
+/// KALEIDOSCOPE_INIT_PLUGINS(..., QUKEYS_PLUGIN, ...);
+/// @endcode
+///
+template<typename _Plugin>
+class ProfiledPlugin : public kaleidoscope::Plugin
+{
+   public:
+
+      /// @brief Constructor.
+      /// @param plugin The plugin to profile.
+      /// @param name The name the plugin is listed with.
+      ///
+      ProfiledPlugin(_Plugin &plugin, const char *name)
+         :  plugin_(plugin),
+            name_(name)
+      {}
+
+      EventHandlerResult onSetup() {
+         return this->profile(HookProfiler::on_setup, 
+                              [this]() { return plugin_.onSetup(); });
+      }
+
+      EventHandlerResult beforeEachCycle() {
+         return this->profile(HookProfiler::before_each_cycle, 
+                              [this]() { return plugin_.beforeEachCycle(); });
+      }
+
+      EventHandlerResult onKeyswitchEvent(Key &mapped_key, KeyAddr key_addr, uint8_t key_state) {
+         return this->profile(HookProfiler::on_keyswitch_event, 
+                              [&]() { return plugin_.onKeyswitchEvent(mapped_key, key_addr, key_state); });
+      }
+
+      EventHandlerResult onFocusEvent(const char *command) {
+         return this->profile(HookProfiler::on_focus_event, 
+                              [&]() { return plugin_.onFocusEvent(command); });
+      }
+
+      EventHandlerResult onNameQuery() {
+         return this->profile(HookProfiler::on_name_query, 
+                              [this]() { return plugin_.onNameQuery(); });
+      }
+
+      EventHandlerResult onLayerChange() {
+         return this->profile(HookProfiler::on_layer_change, 
+                              [this]() { return plugin_.onLayerChange(); });
+      }
+
+      EventHandlerResult onLEDModeChange() {
+         return this->profile(HookProfiler::on_led_mode_change, 
+                              [this]() { return plugin_.onLEDModeChange(); });
+      }
+
+      EventHandlerResult beforeSyncingLeds() {
+         return this->profile(HookProfiler::before_syncing_leds, 
+                              [this]() { return plugin_.beforeSyncingLeds(); });
+      }
+
+      EventHandlerResult beforeReportingState() {
+         return this->profile(HookProfiler::before_reporting_state, 
+                              [this]() { return plugin_.beforeReportingState(); });
+      }
+
+      EventHandlerResult afterEachCycle() {
+         return this->profile(HookProfiler::after_each_cycle, 
+                              [this]() { return plugin_.afterEachCycle(); });
+      }
+
+      template<typename _Sketch>
+      EventHandlerResult exploreSketch() {
+         return plugin_.template exploreSketch<_Sketch>();
+      }
+
+   private:
+
+      template<typename _Func>
+      EventHandlerResult profile(HookProfiler::Hook hook, _Func f) {
+
+         auto core = SimulatorCore::getActive();
+
+         if(!core) {
+            return f();
+         }
+
+         auto &profiler = core->getHookProfiler();
+         auto &trace_writer = core->getTraceWriter();
+         
+         if(!profiler.isEnabled() && !trace_writer.isOpen()) {
+            return f();
+         }
+
+         auto start = std::chrono::steady_clock::now();
+         auto result = f();
+         auto end = std::chrono::steady_clock::now();
+
+         if(profiler.isEnabled()) {
+            
+            // The id is only valid for the profiler it was registered with.
+            // Comparing generations instead of addresses also covers profilers
+            // that reuse the address of a former one, and ids that were rolled 
+            // back by restoring a firmware snapshot.
+            //
+            if(profiler_generation_ != profiler.getGeneration()) {
+               plugin_id_ = profiler.registerPlugin(name_);
+               profiler_generation_ = profiler.getGeneration();
+            }
+            profiler.recordHookCall(plugin_id_, hook,
+               std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+         }
+         
+         if(trace_writer.isOpen()) {
+            trace_writer.addHookCall(name_, HookProfiler::getHookName(hook), 
+                                     core->getTime(), start, end);
+         }
+
+         return result;
+      }
+
+   private:
+
+      _Plugin &plugin_;
+      const char *name_;
+      uint64_t profiler_generation_ = 0;
+      uint16_t plugin_id_ = 0;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
+
+/// @brief Defines a profiling proxy named profiled_<PLUGIN> for a plugin object.
+///
+#define KALEIDOSCOPE_SIMULATOR_PROFILED_PLUGIN(PLUGIN)                          \
+   kaleidoscope::simulator::ProfiledPlugin<decltype(PLUGIN)>                   \
+      profiled_##PLUGIN{PLUGIN, #PLUGIN};
@@ -18,73 +18,297 @@
 
 #include "kaleidoscope_simulator/Simulator.h"
 #include "kaleidoscope_simulator/SimulatorCore.h"
-#include "kaleidoscope_simulator/reports/KeyboardReport.h"
-#include "kaleidoscope_simulator/reports/BootKeyboardReport.h"
-#include "kaleidoscope_simulator/reports/MouseReport.h"
-#include "kaleidoscope_simulator/reports/AbsoluteMouseReport.h"
 
 #include "Kaleidoscope.h"
 #include "HIDReportObserver.h"
 
 #include <iostream>
+#include <assert.h>
 
 namespace kaleidoscope {
 namespace simulator {
    
+namespace {
+   
+// Passes a report to the simulator with its static type.
+//
+struct ReportProcessor
+{
+   papilio::Simulator &simulator;
+   
+   template<typename _ReportType>
+   void operator()(const _ReportType &report) const {
+      simulator.processReport(report);
+   }
+};
+   
+} // namespace
+   
+thread_local Simulator *Simulator::active_ = nullptr;
+thread_local Simulator *Simulator::last_context_ = nullptr;
+   
    Simulator::Simulator(std::ostream &out)
-   :  papilio::Simulator{out}
+   :  papilio::Simulator{out},
+      previous_context_{last_context_}
 {
-   this->setCore(
-      std::shared_ptr<SimulatorCore>{
-                        new SimulatorCore{}
-      }
-   );
+   if(previous_context_) {
+      previous_context_->next_context_ = this;
+   }
+   last_context_ = this;
+   
+   core_ = new SimulatorCore{};
+   
+   // Activate before the core is registered as setting the core might
+   // already cause time to be set.
+   //
+   this->activate();
+   
+   this->setCore(std::shared_ptr<SimulatorCore>{core_});
    
    HIDReportObserver::resetHook(&Simulator::processHIDReport);
    
    Kaleidoscope.device().keyScanner().setEnableReadMatrix(false);
 }
 
-Simulator &Simulator::getInstance() {
-   static Simulator sim{std::cout};
-   return sim;
+   Simulator::~Simulator()
+{
+   // Contexts may be destroyed in any order. Thus, unlink this context
+   // from the chain of contexts of the thread.
+   //
+   if(previous_context_) {
+      previous_context_->next_context_ = next_context_;
+   }
+   if(next_context_) {
+      next_context_->previous_context_ = previous_context_;
+   }
+   else {
+      last_context_ = previous_context_;
+   }
+   
+   // No context is left that could receive the firmware's reports.
+   //
+   if(!last_context_) {
+      HIDReportObserver::resetHook(nullptr);
+   }
+   
+   if(active_ != this) { return; }
+   
+   if(last_context_) {
+      last_context_->activate();
+   }
+   else {
+      active_ = nullptr;
+      SimulatorCore::deactivate();
+   }
+}
+
+void Simulator::activate()
+{
+   active_ = this;
+   core_->activate();
+}
+
+void Simulator::setPressedKeys(const KeyMatrix &pressed)
+{
+   core_->setPressedKeys(pressed);
+}
+
+void Simulator::togglePressedKeys(const KeyMatrix &delta)
+{
+   core_->togglePressedKeys(delta);
+}
+
+const KeyMatrix &Simulator::getPressedKeys() const
+{
+   return core_->getPressedKeys();
+}
+
+void Simulator::takeSnapshot(FirmwareSnapshot &snapshot) const
+{
+   core_->takeSnapshot(snapshot);
+}
+
+void Simulator::restoreSnapshot(const FirmwareSnapshot &snapshot)
+{
+   core_->restoreSnapshot(snapshot);
+   this->setTime(snapshot.getTime());
+   
+   // The reports emitted since the snapshot was taken are 
+   // no predecessors of the reports that follow.
+   //
+   for(auto &report: last_reports_) {
+      report = HIDReport{};
+   }
+   report_delta_ = ReportDelta{};
+   
+   // The history must not run backwards in time.
+   //
+   report_history_.clear();
+}
+
+void Simulator::setIdleFastForward(bool state, uint32_t max_time_step)
+{
+   core_->setIdleFastForward(state, max_time_step);
+}
+
+HookProfiler &Simulator::getHookProfiler()
+{
+   return core_->getHookProfiler();
+}
+
+TraceWriter &Simulator::getTraceWriter()
+{
+   return core_->getTraceWriter();
+}
+
+void Simulator::setAglaisRecorder(AglaisRecorder *recorder)
+{
+   auto previous = core_->getAglaisRecorder();
+   if(previous && (previous != recorder)) {
+      previous->finish(core_->getTime());
+   }
+   core_->setAglaisRecorder(recorder);
+}
+
+bool Simulator::advanceToNextDeadline(uint32_t time_limit)
+{
+   uint32_t deadline;
+   if(!virtual_clock_.getNextDeadline(core_->getTime(), deadline)
+         || (deadline > time_limit)) {
+      return false;
+   }
+   
+   this->setTime(deadline);
+   virtual_clock_.runDueActions(deadline);
+   this->cycle();
+   
+   // The cycle must not move time past the deadline.
+   //
+   this->setTime(deadline);
+   
+   return true;
+}
+
+void Simulator::runUntil(uint32_t end_time)
+{
+   while(this->advanceToNextDeadline(end_time)) {}
+   
+   if(core_->getTime() < end_time) {
+      this->setTime(end_time);
+      virtual_clock_.runDueActions(end_time);
+      this->cycle();
+      this->setTime(end_time);
+   }
+}
+
+uint32_t Simulator::getStepEnd(uint32_t time, uint32_t time_step, 
+                               uint32_t end_time) const
+{
+   uint32_t step_end = end_time;
+   if(end_time - time > time_step) {
+      step_end = time + time_step;
+   }
+   
+   uint32_t deadline;
+   if(virtual_clock_.getNextDeadline(time, deadline) 
+         && (deadline < step_end)) {
+      step_end = deadline;
+   }
+   
+   return step_end;
+}
+
+void Simulator::fastForwardUntil(uint32_t end_time, uint32_t time_step)
+{
+   assert(time_step > 0);
+   
+   while(core_->getTime() < end_time) {
+      
+      auto time = core_->getTime();
+      
+      if(!core_->isQuiescent()) {
+         virtual_clock_.runDueActions(time);
+         this->cycle();
+         
+         // Time advances by the given step, regardless of whether 
+         // the cycle advanced it.
+         //
+         this->setTime(this->getStepEnd(time, time_step, end_time));
+         continue;
+      }
+      
+      auto next_time = this->getStepEnd(time, core_->getMaxIdleTimeStep(), end_time);
+      
+      this->setTime(next_time);
+      virtual_clock_.runDueActions(next_time);
+      
+      // The firmware must see every step, even a short one
+      // that ends at a deadline.
+      //
+      core_->wakeUp();
+      this->cycle();
+      this->setTime(next_time);
+   }
 }
 
 void Simulator::processHIDReport(uint8_t id, const void* data, 
                                     int len, int result)
 {
-   auto &simulator = Simulator::getInstance();
+   if(!active_) { return; }
    
-   switch(id) {
-      // TODO: React appropriately on the following
-      //
-      case HID_REPORTID_GAMEPAD:
-      case HID_REPORTID_CONSUMERCONTROL:
-      case HID_REPORTID_SYSTEMCONTROL:
-         simulator.log() << "***Ignoring hid report with id = " << id;
-         break;
-      case HID_REPORTID_KEYBOARD:
-         {
-            simulator.processReport(BootKeyboardReport{data});
-         }
-         break;
-      case HID_REPORTID_MOUSE_ABSOLUTE:
-         {
-            simulator.processReport(AbsoluteMouseReport{data});
-         }
-         break;
-      case HID_REPORTID_MOUSE:
-         {
-            simulator.processReport(MouseReport{data});
-         }
-         break;
-      case HID_REPORTID_NKRO_KEYBOARD:
-         {
-            simulator.processReport(KeyboardReport{data});
-         }
-         break;
-      default:
-         simulator.error() << "Encountered unknown HID report with id = " << id;
+   auto &simulator = *active_;
+   
+   auto &core = *simulator.core_;
+   
+   core.registerHIDReport();
+   
+   if(auto recorder = core.getAglaisRecorder()) {
+      recorder->onHIDReport(id, static_cast<const uint8_t*>(data), len);
+   }
+   
+   if(simulator.hid_report_hook_) {
+      simulator.hid_report_hook_(id, static_cast<const uint8_t*>(data), len);
+   }
+   
+   auto &trace_writer = core.getTraceWriter();
+   bool tracing = trace_writer.isOpen();
+   
+   TraceWriter::Clock::time_point start;
+   if(tracing) {
+      trace_writer.addHIDReport(id, len, core.getTime());
+      start = TraceWriter::Clock::now();
+   }
+   
+   HIDReport report{id, data};
+   
+   if(report.getType() != HIDReportType::none) {
+      
+      auto &last_report = simulator.last_reports_[int(report.getType())];
+      
+      simulator.report_delta_ = ReportDelta{last_report, report};
+      last_report = report;
+      
+      simulator.report_history_.add(report, core.getCycleCount(), core.getTime());
+      
+      report.visit(ReportProcessor{simulator});
+   }
+   else {
+      switch(id) {
+         // TODO: React appropriately on the following
+         //
+         case HID_REPORTID_GAMEPAD:
+         case HID_REPORTID_CONSUMERCONTROL:
+         case HID_REPORTID_SYSTEMCONTROL:
+            simulator.log() << "***Ignoring hid report with id = " << id;
+            break;
+         default:
+            simulator.error() << "Encountered unknown HID report with id = " << id;
+      }
+   }
+   
+   if(tracing) {
+      trace_writer.addReportProcessing(id, core.getTime(), 
+                                       start, TraceWriter::Clock::now());
    }
 }
 
@@ -19,6 +19,16 @@
 #pragma once
 
 #include "papilio/Simulator.h"
+#include "kaleidoscope_simulator/KeyMatrix.h"
+#include "kaleidoscope_simulator/VirtualClock.h"
+#include "kaleidoscope_simulator/HookProfiler.h"
+#include "kaleidoscope_simulator/TraceWriter.h"
+#include "kaleidoscope_simulator/reports/HIDReport.h"
+#include "kaleidoscope_simulator/reports/ReportDelta.h"
+#include "kaleidoscope_simulator/reports/ReportHistory.h"
+
+#include <ostream>
+#include <functional>
 
 /// @namespace kaleidoscope
 ///
@@ -28,22 +38,254 @@ namespace kaleidoscope {
 ///
 namespace simulator {
    
+class SimulatorCore;
+class FirmwareSnapshot;
+class AglaisRecorder;
+   
 /// @brief A Kaleidoscope specific simulator class.
+/// @details Every simulator object is an independent simulation context
+///        with its own virtual time, its own HID report routing and its
+///        own output stream. A context becomes the active context of
+///        the thread that constructs it. Calls that originate from
+///        the firmware, e.g. millis() or the emission of HID reports, are 
+///        routed to the active context of the calling thread.
+///        If the active context is destroyed, the most recently
+///        constructed of the remaining contexts of the thread 
+///        becomes active. Contexts may be destroyed in any order.
+///
+///        Please note that the firmware itself (Kaleidoscope and its plugins)
+///        is global to the process. Contexts that are supposed
+///        to be driven concurrently must therefore live in separate
+///        processes.
 ///
 class Simulator : public papilio::Simulator
 {
    public:
       
-      /// @brief Access the global simulator singleton.
+      /// @brief A function that observes the HID reports emitted by the firmware.
+      /// @param id The report id.
+      /// @param data The report's data.
+      /// @param length The length of the report's data in bytes.
       ///
-      static Simulator &getInstance();
-      
-   private:
+      typedef std::function<void(uint8_t id, const uint8_t *data, int length)> 
+                                                            HIDReportHook;
       
+      /// @brief Constructor.
+      /// @param out The stream that the simulator's output is written to.
+      ///
       Simulator(std::ostream &out);
       
+      ~Simulator();
+      
+      Simulator(const Simulator &) = delete;
+      Simulator &operator=(const Simulator &) = delete;
+      
+      /// @brief Makes this simulator the active context of the calling thread.
+      ///
+      void activate();
+      
+      /// @brief Detaches the calling thread from any context.
+      /// @details HID reports that the firmware emits are discarded 
+      ///        until a context is activated again. The firmware's time
+      ///        source is not changed (see SimulatorCore::deactivate()).
+      ///
+      static void deactivate() { active_ = nullptr; }
+      
+      /// @brief Access the active context of the calling thread.
+      /// @returns The active simulator or nullptr if there is none.
+      ///
+      static Simulator *getActive() { return active_; }
+      
+      /// @brief Access the Kaleidoscope specific simulator core.
+      ///
+      SimulatorCore &getSimulatorCore() { return *core_; }
+      const SimulatorCore &getSimulatorCore() const { return *core_; }
+      
+      /// @brief Applies a complete keyboard matrix state.
+      /// @details Keys whose bits are set are pressed, all other keys 
+      ///        are released.
+      /// @param pressed The new state of the entire matrix.
+      ///
+      void setPressedKeys(const KeyMatrix &pressed);
+      
+      /// @brief Toggles the state of a set of keys.
+      /// @param delta The keys to toggle.
+      ///
+      void togglePressedKeys(const KeyMatrix &delta);
+      
+      /// @brief Queries the state of the entire keyboard matrix.
+      /// @returns A matrix whose bits are set for all keys that are
+      ///        currently pressed.
+      ///
+      const KeyMatrix &getPressedKeys() const;
+      
+      /// @brief Captures the entire state of the virtual firmware.
+      /// @param snapshot The snapshot object to store the state in.
+      ///
+      void takeSnapshot(FirmwareSnapshot &snapshot) const;
+      
+      /// @brief Restores a previously captured firmware state.
+      /// @details The simulator's clock is reset to the time
+      ///        of the snapshot. The last reports, the report delta 
+      ///        and the report history are cleared. The delta of the next report of every type
+      ///        is thus computed with respect to an empty report.
+      /// @param snapshot The snapshot to restore.
+      ///
+      void restoreSnapshot(const FirmwareSnapshot &snapshot);
+      
+      /// @brief Enables or disables fast-forwarding of idle cycles.
+      /// @details See SimulatorCore::setIdleFastForward(...) for details.
+      /// @param state The enable state.
+      /// @param max_time_step The max. amount of simulated time [ms] that 
+      ///        may pass between two firmware loop calls while the
+      ///        firmware is quiescent.
+      ///
+      void setIdleFastForward(bool state, uint32_t max_time_step = 100);
+      
+      /// @brief Access the profiler that records the cost of plugin hooks.
+      /// @details See ProfiledPlugin.h on how to profile plugins.
+      ///
+      HookProfiler &getHookProfiler();
+      
+      /// @brief Access the writer that records a trace of the simulation.
+      /// @details Open the writer to start tracing. The trace file can
+      ///        be viewed with Perfetto or chrome://tracing. 
+      ///        Plugin hooks only appear in the trace if the plugins 
+      ///        are profiled (see ProfiledPlugin.h).
+      ///
+      TraceWriter &getTraceWriter();
+      
+      /// @brief Starts or stops recording the simulation as Aglais document.
+      /// @details Key actions, HID reports and the timing of all 
+      ///        subsequent cycles are recorded. Passing nullptr 
+      ///        finishes the document of the recorder that is 
+      ///        currently attached and detaches it.
+      /// @param recorder The recorder or nullptr.
+      ///
+      void setAglaisRecorder(AglaisRecorder *recorder);
+      
+      /// @brief Access the virtual clock that knows about upcoming deadlines.
+      /// @details Register deadline providers for plugin timeouts
+      ///        or LED effect frames with the clock and schedule test
+      ///        actions to be executed at given points in time.
+      ///
+      VirtualClock &getVirtualClock() { return virtual_clock_; }
+      const VirtualClock &getVirtualClock() const { return virtual_clock_; }
+      
+      /// @brief Schedules an action to be executed at a given time.
+      /// @details The action is executed right before the cycle
+      ///        that is run at the scheduled time.
+      /// @param time The time [ms] at which the action is due.
+      /// @param action The action to execute.
+      ///
+      void scheduleAt(uint32_t time, VirtualClock::ScheduledAction action) {
+         virtual_clock_.scheduleAt(time, std::move(action));
+      }
+      
+      /// @brief Advances time straight to the next deadline and runs 
+      ///        a single cycle there.
+      /// @details Afterwards, the time is that of the deadline.
+      /// @param time_limit Deadlines after this time [ms] are ignored.
+      /// @returns True if a deadline was found and processed.
+      ///
+      bool advanceToNextDeadline(uint32_t time_limit = 0xFFFFFFFF);
+      
+      /// @brief Runs the simulation until a given point in time,
+      ///        only visiting the deadlines known to the virtual clock.
+      /// @details Finally, a cycle is run at the end time.
+      ///        Afterwards, the time is exactly the end time.
+      /// @param end_time The time [ms] to advance to.
+      ///
+      void runUntil(uint32_t end_time);
+      
+      /// @brief Runs the simulation until a given point in time,
+      ///        skipping cycles while the firmware is quiescent.
+      /// @details Regular cycles are run as long as the firmware is
+      ///        not quiescent (see SimulatorCore::setIdleFastForward(...)).
+      ///        While quiescent, time advances directly by the max.
+      ///        idle time step, but never beyond the next deadline known 
+      ///        to the virtual clock, and a single cycle is run there.
+      ///        Without idle fast-forwarding enabled, the firmware is 
+      ///        never quiescent and all cycles are run.
+      ///        Time is advanced explicitly after every cycle. 
+      ///        Afterwards, the time is exactly the end time.
+      /// @param end_time The time [ms] to advance to.
+      /// @param time_step The amount of simulated time [ms] that passes
+      ///        with every cycle while the firmware is not quiescent.
+      ///        Must be non-zero.
+      ///
+      void fastForwardUntil(uint32_t end_time, uint32_t time_step = 1);
+      
+      /// @brief Registers a function that observes all HID reports.
+      /// @details The hook is called for every report emitted
+      ///        by the firmware before the report is processed 
+      ///        by the simulator's report queue.
+      /// @param hook The hook function. Pass an empty function to
+      ///        unregister a hook.
+      ///
+      void setHIDReportHook(HIDReportHook hook) { 
+         hid_report_hook_ = std::move(hook); 
+      }
+      
+      /// @brief Access the function that observes all HID reports.
+      ///
+      const HIDReportHook &getHIDReportHook() const { return hid_report_hook_; }
+      
+      /// @brief Access the difference between the report that is currently
+      ///        processed and the previous report of the same type.
+      /// @details The delta is computed once for every report, before
+      ///        the report is processed. Report actions may thus
+      ///        query it.
+      ///
+      const ReportDelta &getReportDelta() const { return report_delta_; }
+      
+      /// @brief Access the last report of a given type that was emitted.
+      /// @details The report is of type none if no report of the
+      ///        type was emitted since the simulator was created 
+      ///        or a snapshot was restored.
+      /// @param type The report type.
+      ///
+      const HIDReport &getLastReport(HIDReportType type) const { 
+         return last_reports_[int(type)]; 
+      }
+      
+      /// @brief Access the history of the reports emitted by the firmware.
+      /// @details Every report is added to the history before it
+      ///        is processed. Report actions can thus query
+      ///        previous reports. Use ReportHistory::setCapacity(...)
+      ///        to change the number of reports retained.
+      ///        The history is cleared when a snapshot is restored.
+      ///
+      ReportHistory &getReportHistory() { return report_history_; }
+      const ReportHistory &getReportHistory() const { return report_history_; }
+      
+   private:
+      
       static void processHIDReport(uint8_t id, const void* data, 
                                     int len, int result);
+      
+      uint32_t getStepEnd(uint32_t time, uint32_t time_step, 
+                          uint32_t end_time) const;
+      
+   private:
+      
+      SimulatorCore *core_ = nullptr;
+      
+      // The contexts of a thread in the order of their construction.
+      //
+      Simulator *previous_context_ = nullptr;
+      Simulator *next_context_ = nullptr;
+      
+      VirtualClock virtual_clock_;
+      
+      HIDReportHook hid_report_hook_;
+      
+      HIDReport last_reports_[int(HIDReportType::absolute_mouse) + 1];
+      ReportDelta report_delta_;
+      ReportHistory report_history_;
+      
+      static thread_local Simulator *active_;
+      static thread_local Simulator *last_context_;
 };
 
 } // namespace simulator
@@ -19,6 +19,13 @@
 #pragma once
 
 #include "papilio/SimulatorCore_.h"
+#include "kaleidoscope_simulator/FirmwareSnapshot.h"
+#include "kaleidoscope_simulator/KeyMatrix.h"
+#include "kaleidoscope_simulator/HookProfiler.h"
+#include "kaleidoscope_simulator/TraceWriter.h"
+#include "kaleidoscope_simulator/AglaisRecorder.h"
+
+#include <vector>
 
 namespace kaleidoscope {
 namespace simulator {
@@ -28,6 +35,12 @@ namespace simulator {
 class SimulatorCore : public papilio::SimulatorCore_
 {
    public:
+      
+      /// @brief Destructor.
+      /// @details Finishes the document of an attached Aglais recorder
+      ///        and detaches it.
+      ///
+      virtual ~SimulatorCore();
 
       virtual void init() override;
 
@@ -41,6 +54,30 @@ class SimulatorCore : public papilio::SimulatorCore_
 
       virtual bool isKeyPressed(uint8_t row, uint8_t col) const override;
       
+      /// @brief Applies a complete keyboard matrix state.
+      /// @details Keys whose bits are set are pressed, all other keys 
+      ///        are released. Only keys that change state are 
+      ///        passed on to the key scanner.
+      /// @param pressed The new state of the entire matrix.
+      ///
+      void setPressedKeys(const KeyMatrix &pressed);
+      
+      /// @brief Toggles the state of a set of keys.
+      /// @details Every key whose bit is set in the delta is pressed if 
+      ///        it is currently not pressed and released otherwise.
+      /// @param delta The keys to toggle.
+      ///
+      void togglePressedKeys(const KeyMatrix &delta);
+      
+      /// @brief Queries the state of the entire keyboard matrix.
+      /// @details The state is mirrored by the core as keys are pressed, 
+      ///        released and tapped through the simulator. The key 
+      ///        scanner is only queried after a snapshot was restored.
+      /// @returns A matrix whose bits are set for all keys that are
+      ///        currently pressed.
+      ///
+      const KeyMatrix &getPressedKeys() const { return pressed_keys_; }
+      
       virtual uint8_t getNumLEDs() const override;
 
       virtual void getCurrentKeyLEDColor(uint8_t key_offset, 
@@ -54,6 +91,179 @@ class SimulatorCore : public papilio::SimulatorCore_
       virtual const char *keycodeToName(uint8_t keycode) const override;
       
       virtual void loop() override;
+      
+      /// @brief Retreives the current time of the simulation context.
+      /// @returns The time in [ms].
+      ///
+      uint32_t getTime() const { return time_; }
+      
+      /// @brief Makes this core the time source for the calling thread.
+      /// @details The firmware's millis() function reports the time of
+      ///        the active core.
+      ///
+      void activate() { active_ = this; }
+      
+      /// @brief Detaches the calling thread from any core.
+      ///
+      static void deactivate() { active_ = nullptr; }
+      
+      /// @brief Access the active core of the calling thread.
+      /// @returns The active core or nullptr if there is none.
+      ///
+      static SimulatorCore *getActive() { return active_; }
+      
+      /// @brief Captures the entire state of the virtual firmware.
+      /// @details This includes the key scanner's keystates, the layer
+      ///        stack, the LED buffer, all plugin globals and the current
+      ///        time.
+      /// @param snapshot The snapshot object to store the state in.
+      ///
+      void takeSnapshot(FirmwareSnapshot &snapshot) const;
+      
+      /// @brief Restores a previously captured firmware state.
+      /// @param snapshot The snapshot to restore.
+      ///
+      void restoreSnapshot(const FirmwareSnapshot &snapshot);
+      
+      /// @brief Enables or disables fast-forwarding of idle cycles.
+      /// @details The firmware is quiescent after a cycle
+      ///        during which no key was held, no report was emitted and
+      ///        the LED buffer did not change. Any key action ends 
+      ///        quiescence immediately.
+      ///
+      ///        If enabled, cycles still run one after the other 
+      ///        but the firmware's loop function is skipped 
+      ///        as long as the firmware is quiescent. It is only run 
+      ///        whenever the simulated time advanced by more than the 
+      ///        max. time step. Thus, the firmware sees time advance in 
+      ///        large steps. To skip the idle cycles altogether and 
+      ///        advance time directly, use Simulator::fastForwardUntil(...).
+      ///
+      ///        Timers that are pending without any visible effect 
+      ///        (e.g. plugin timeouts) may expire up to one time step late.
+      /// @param state The enable state.
+      /// @param max_time_step The max. amount of simulated time [ms] that 
+      ///        may pass between two firmware loop calls while quiescent.
+      ///
+      void setIdleFastForward(bool state, uint32_t max_time_step = 100);
+      
+      /// @brief Queries whether the firmware was found quiescent during the
+      ///        last cycle.
+      ///
+      bool isQuiescent() const { return quiescent_; }
+      
+      /// @brief Retreives the max. amount of simulated time [ms] that 
+      ///        may pass between two firmware loop calls while quiescent.
+      ///
+      uint32_t getMaxIdleTimeStep() const { return max_idle_time_step_; }
+      
+      /// @brief Makes sure that the firmware's loop function is run 
+      ///        during the next cycle.
+      /// @details Quiescence is determined again after that cycle.
+      ///
+      void wakeUp() { quiescent_ = false; }
+      
+      /// @brief Enables or disables tracking of changes of the LEDs.
+      /// @details Tracking is implicitly active while idle cycles are 
+      ///        fast-forwarded.
+      /// @param state The enable state.
+      ///
+      void setTrackLEDChanges(bool state);
+      
+      /// @brief Queries whether any LED changed its color during the
+      ///        last cycle.
+      /// @details Only valid while LED changes are tracked.
+      ///
+      bool haveLEDsChanged() const { return leds_changed_; }
+      
+      /// @brief Queries whether the firmware loop was run during the 
+      ///        last cycle.
+      ///
+      bool wasLoopRun() const { return loop_run_; }
+      
+      /// @brief Must be called for every HID report that the firmware emits.
+      ///
+      void registerHIDReport() { ++n_reports_in_loop_; }
+      
+      /// @brief Retreives the number of HID reports emitted during the
+      ///        last firmware loop.
+      ///
+      uint16_t getNumReportsInLoop() const { return n_reports_in_loop_; }
+      
+      /// @brief Access the profiler that records the cost of plugin hooks.
+      /// @details While the profiler is enabled, the core also records
+      ///        the overall time spent in the firmware loop.
+      ///
+      HookProfiler &getHookProfiler() { return hook_profiler_; }
+      const HookProfiler &getHookProfiler() const { return hook_profiler_; }
+      
+      /// @brief Access the writer that traces cycles, hooks, key actions
+      ///        and HID reports.
+      /// @details Tracing is active while the writer is open.
+      ///
+      TraceWriter &getTraceWriter() { return trace_writer_; }
+      
+      /// @brief Attaches a recorder that records the simulation as
+      ///        Aglais document.
+      /// @details A recorder that is destroyed while attached
+      ///        detaches itself.
+      /// @param recorder The recorder or nullptr to detach the 
+      ///        current recorder.
+      ///
+      void setAglaisRecorder(AglaisRecorder *recorder);
+      
+      /// @brief Access the attached Aglais recorder.
+      /// @returns The recorder or nullptr if there is none.
+      ///
+      AglaisRecorder *getAglaisRecorder() const { return aglais_recorder_; }
+      
+      /// @brief Retreives the number of cycles run so far, including
+      ///        cycles whose firmware loop was skipped.
+      ///
+      uint32_t getCycleCount() const { return cycle_count_; }
+      
+   private:
+      
+      bool checkQuiescence();
+      bool updateLEDState();
+      void readPressedKeys();
+      
+      void traceKeyAction(const char *action, uint8_t row, uint8_t col) {
+         if(trace_writer_.isOpen()) {
+            trace_writer_.addKeyAction(action, row, col, time_);
+         }
+      }
+      
+      void recordKeyAction(uint8_t row, uint8_t col, bool pressed) {
+         if(aglais_recorder_) {
+            aglais_recorder_->onKeyAction(row, col, pressed);
+         }
+      }
+      
+   private:
+      
+      uint32_t time_ = 0;
+      uint32_t cycle_count_ = 0;
+      
+      bool idle_fast_forward_ = false;
+      uint32_t max_idle_time_step_ = 100;
+      bool quiescent_ = false;
+      bool track_led_changes_ = false;
+      bool leds_changed_ = false;
+      bool loop_run_ = false;
+      uint32_t last_loop_time_ = 0;
+      uint16_t n_reports_in_loop_ = 0;
+      std::vector<uint8_t> led_state_;
+      
+      // The keys that are pressed, mirrors the key scanner's state.
+      //
+      KeyMatrix pressed_keys_;
+      
+      HookProfiler hook_profiler_;
+      TraceWriter trace_writer_;
+      AglaisRecorder *aglais_recorder_ = nullptr;
+      
+      static thread_local SimulatorCore *active_;
 };
 
 } // namespace simulator
@@ -0,0 +1,254 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/TraceWriter.h"
+#include "kaleidoscope_simulator/aux/exceptions.h"
+
+#include <iostream>
+#include <exception>
+
+namespace kaleidoscope {
+namespace simulator {
+   
+TraceWriter::~TraceWriter()
+{
+   // Destructors must not throw. Write errors are thus only reported.
+   //
+   try {
+      this->close();
+   }
+   catch(const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+   }
+}
+
+void TraceWriter::open(const char *filename, size_t flush_threshold)
+{
+   this->close();
+   
+   file_ = fopen(filename, "wb");
+   
+   if(!file_) {
+      KS_T_EXCEPTION("Unable to open trace file \'" << filename << "\'")
+   }
+   
+   filename_ = filename;
+   flush_threshold_ = flush_threshold;
+   buffer_.clear();
+   buffer_.reserve(flush_threshold_ + 1024);
+   origin_ = Clock::now();
+   n_events_ = 0;
+   
+   buffer_ += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+              "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\","
+                 "\"args\":{\"name\":\"Kaleidoscope-Simulator\"}},\n"
+              "{\"ph\":\"M\",\"pid\":1,\"tid\":1,\"name\":\"thread_name\","
+                 "\"args\":{\"name\":\"firmware\"}}";
+}
+
+void TraceWriter::close()
+{
+   if(!file_) { return; }
+   
+   buffer_ += "\n]}\n";
+   this->flush();
+   
+   // Data buffered by stdio is only written when the file is closed.
+   //
+   int status = fclose(file_);
+   file_ = nullptr;
+   
+   // Release the buffer's memory.
+   //
+   std::string{}.swap(buffer_);
+   
+   if(status != 0) {
+      KS_T_EXCEPTION("Unable to complete trace file \'" << filename_ << "\'")
+   }
+}
+
+void TraceWriter::discard()
+{
+   // The FILE object is not closed as this would flush its 
+   // stdio buffer. It is shared with the parent process.
+   //
+   file_ = nullptr;
+   std::string{}.swap(buffer_);
+}
+
+void TraceWriter::addCycle(uint32_t cycle, uint32_t millis, 
+                           Clock::time_point start, Clock::time_point end,
+                           bool loop_run)
+{
+   this->beginEvent('X', "cycle", start);
+   buffer_ += ",\"name\":\"cycle\"";
+   this->appendDuration(start, end);
+   this->appendArg("cycle", cycle);
+   this->appendArg("millis", millis);
+   this->appendArg("loop_run", loop_run);
+   this->endEvent();
+}
+
+void TraceWriter::addHookCall(const char *plugin, const char *hook, uint32_t millis,
+                              Clock::time_point start, Clock::time_point end)
+{
+   this->beginEvent('X', "hook", start);
+   buffer_ += ",\"name\":\"";
+   this->appendString(plugin);
+   buffer_ += '.';
+   this->appendString(hook);
+   buffer_ += '\"';
+   this->appendDuration(start, end);
+   this->appendArg("millis", millis);
+   this->endEvent();
+}
+
+void TraceWriter::addReportProcessing(uint8_t report_id, uint32_t millis,
+                                      Clock::time_point start, Clock::time_point end)
+{
+   this->beginEvent('X', "report", start);
+   buffer_ += ",\"name\":\"process_report\"";
+   this->appendDuration(start, end);
+   this->appendArg("report_id", report_id);
+   this->appendArg("millis", millis);
+   this->endEvent();
+}
+
+void TraceWriter::addKeyAction(const char *action, uint8_t row, uint8_t col, 
+                               uint32_t millis)
+{
+   this->beginEvent('i', "key", Clock::now());
+   buffer_ += ",\"s\":\"t\",\"name\":\"";
+   this->appendString(action);
+   buffer_ += '\"';
+   this->appendArg("row", row);
+   this->appendArg("col", col);
+   this->appendArg("millis", millis);
+   this->endEvent();
+}
+
+void TraceWriter::addHIDReport(uint8_t report_id, int length, uint32_t millis)
+{
+   this->beginEvent('i', "report", Clock::now());
+   buffer_ += ",\"s\":\"t\",\"name\":\"hid_report\"";
+   this->appendArg("report_id", report_id);
+   this->appendArg("length", (length > 0) ? length : 0);
+   this->appendArg("millis", millis);
+   this->endEvent();
+}
+
+void TraceWriter::beginEvent(char phase, const char *category, Clock::time_point ts)
+{
+   buffer_ += ",\n{\"ph\":\"";
+   buffer_ += phase;
+   buffer_ += "\",\"cat\":\"";
+   buffer_ += category;
+   buffer_ += "\",\"pid\":1,\"tid\":1,\"ts\":";
+   this->appendMicroseconds(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(ts - origin_).count());
+   first_arg_ = true;
+}
+
+void TraceWriter::appendDuration(Clock::time_point start, Clock::time_point end)
+{
+   buffer_ += ",\"dur\":";
+   this->appendMicroseconds(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+void TraceWriter::appendArg(const char *key, uint64_t value)
+{
+   buffer_ += (first_arg_) ? ",\"args\":{\"" : ",\"";
+   buffer_ += key;
+   buffer_ += "\":";
+   this->appendUnsigned(value);
+   first_arg_ = false;
+}
+
+void TraceWriter::endEvent()
+{
+   if(!first_arg_) {
+      buffer_ += '}';
+   }
+   buffer_ += '}';
+   
+   ++n_events_;
+   
+   if(buffer_.size() >= flush_threshold_) {
+      this->flush();
+   }
+}
+
+void TraceWriter::appendString(const char *s)
+{
+   for(; *s; ++s) {
+      if(*s == '\"' || *s == '\\') {
+         buffer_ += '\\';
+      }
+      buffer_ += *s;
+   }
+}
+
+void TraceWriter::appendUnsigned(uint64_t value)
+{
+   char digits[20];
+   int n = 0;
+   do {
+      digits[n++] = char('0' + value % 10);
+      value /= 10;
+   } while(value);
+   
+   while(n) {
+      buffer_ += digits[--n];
+   }
+}
+
+void TraceWriter::appendMicroseconds(uint64_t ns)
+{
+   // Timestamps are specified in [us]. Three decimal places retain
+   // nanosecond resolution.
+   //
+   this->appendUnsigned(ns / 1000);
+   
+   uint32_t frac = ns % 1000;
+   buffer_ += '.';
+   buffer_ += char('0' + frac / 100);
+   buffer_ += char('0' + (frac / 10) % 10);
+   buffer_ += char('0' + frac % 10);
+}
+
+void TraceWriter::flush()
+{
+   if(buffer_.empty()) { return; }
+   
+   if(fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) {
+      
+      // The trace is incomplete. Stop tracing.
+      //
+      fclose(file_);
+      file_ = nullptr;
+      std::string{}.swap(buffer_);
+      
+      KS_T_EXCEPTION("Unable to write to trace file \'" << filename_ << "\'")
+   }
+   
+   buffer_.clear();
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,155 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string>
+#include <chrono>
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief Writes a trace of the simulation in Chrome's trace event format.
+/// @details The resulting JSON file can be loaded in Perfetto 
+///        (ui.perfetto.dev) or chrome://tracing. Cycles, plugin hooks and 
+///        the processing of HID reports are recorded as nested spans, 
+///        key actions and HID reports as instant events. Event 
+///        timestamps are wall clock times relative to the opening 
+///        of the trace. The simulated time of every event 
+///        is stored as argument 'millis'.
+///
+///        Events are formatted into a memory buffer that is only written 
+///        to the file when it exceeds the flush threshold. If writing
+///        fails, tracing stops and an exception is thrown.
+///
+class TraceWriter
+{
+   public:
+      
+      typedef std::chrono::steady_clock Clock;
+      
+      TraceWriter() {}
+      ~TraceWriter();
+      
+      TraceWriter(const TraceWriter &) = delete;
+      TraceWriter &operator=(const TraceWriter &) = delete;
+      
+      /// @brief Opens a trace file.
+      /// @details A trace that is currently open is closed first.
+      /// @param filename The name of the file to write to.
+      /// @param flush_threshold The buffer size in bytes that triggers
+      ///        writing to the file.
+      ///
+      void open(const char *filename, size_t flush_threshold = 4 << 20);
+      
+      /// @brief Completes the trace and closes the file.
+      /// @details Throws if the trace could not be written completely.
+      ///        The trace is closed in any case.
+      ///
+      void close();
+      
+      /// @brief Stops tracing without writing pending events.
+      /// @details The file is left to the process that opened it.
+      ///        Worker processes that were forked while a trace
+      ///        was open must call this to not corrupt the trace.
+      ///
+      void discard();
+      
+      /// @brief Checks if a trace is being recorded.
+      ///
+      bool isOpen() const { return file_ != nullptr; }
+      
+      /// @brief Retreives the number of events recorded so far.
+      ///
+      uint64_t getNumEvents() const { return n_events_; }
+      
+      /// @brief Records a firmware cycle.
+      /// @param cycle The number of the cycle.
+      /// @param millis The simulated time [ms].
+      /// @param start The wall clock time at the start of the cycle.
+      /// @param end The wall clock time at the end of the cycle.
+      /// @param loop_run False if the firmware loop was skipped.
+      ///
+      void addCycle(uint32_t cycle, uint32_t millis, 
+                    Clock::time_point start, Clock::time_point end,
+                    bool loop_run);
+      
+      /// @brief Records a call to a plugin hook.
+      /// @param plugin The name of the plugin.
+      /// @param hook The name of the hook.
+      /// @param millis The simulated time [ms].
+      /// @param start The wall clock time at the start of the call.
+      /// @param end The wall clock time at the end of the call.
+      ///
+      void addHookCall(const char *plugin, const char *hook, uint32_t millis,
+                       Clock::time_point start, Clock::time_point end);
+      
+      /// @brief Records the processing of a HID report by the simulator.
+      /// @param report_id The HID report id.
+      /// @param millis The simulated time [ms].
+      /// @param start The wall clock time at the start of processing.
+      /// @param end The wall clock time at the end of processing.
+      ///
+      void addReportProcessing(uint8_t report_id, uint32_t millis,
+                               Clock::time_point start, Clock::time_point end);
+      
+      /// @brief Records an action applied to a key.
+      /// @param action The name of the action, e.g. "key_pressed".
+      /// @param row The key's row.
+      /// @param col The key's column.
+      /// @param millis The simulated time [ms].
+      ///
+      void addKeyAction(const char *action, uint8_t row, uint8_t col, 
+                        uint32_t millis);
+      
+      /// @brief Records a HID report emitted by the firmware.
+      /// @param report_id The HID report id.
+      /// @param length The length of the report in bytes.
+      /// @param millis The simulated time [ms].
+      ///
+      void addHIDReport(uint8_t report_id, int length, uint32_t millis);
+      
+   private:
+      
+      void beginEvent(char phase, const char *category, Clock::time_point ts);
+      void appendDuration(Clock::time_point start, Clock::time_point end);
+      void appendArg(const char *key, uint64_t value);
+      void endEvent();
+      
+      void appendString(const char *s);
+      void appendUnsigned(uint64_t value);
+      void appendMicroseconds(uint64_t ns);
+      
+      void flush();
+      
+   private:
+      
+      FILE *file_ = nullptr;
+      std::string filename_;
+      std::string buffer_;
+      size_t flush_threshold_ = 0;
+      Clock::time_point origin_;
+      uint64_t n_events_ = 0;
+      bool first_arg_ = true;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,77 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/VirtualClock.h"
+
+namespace kaleidoscope {
+namespace simulator {
+
+void VirtualClock::addPeriodicDeadline(uint32_t period, uint32_t phase)
+{
+   if(period == 0) { return; }
+   
+   this->addDeadlineProvider(
+      [=](uint32_t now, uint32_t &deadline) -> bool {
+         deadline = now + period - (now - phase) % period;
+         return true;
+      }
+   );
+}
+
+bool VirtualClock::getNextDeadline(uint32_t now, uint32_t &deadline) const
+{
+   bool found = false;
+   
+   auto consider = [&](uint32_t candidate) {
+      if(candidate <= now) { return; }
+      if(!found || candidate < deadline) {
+         deadline = candidate;
+         found = true;
+      }
+   };
+   
+   auto it = scheduled_actions_.upper_bound(now);
+   if(it != scheduled_actions_.end()) {
+      consider(it->first);
+   }
+   
+   for(const auto &provider: deadline_providers_) {
+      uint32_t candidate;
+      if(provider(now, candidate)) {
+         consider(candidate);
+      }
+   }
+   
+   return found;
+}
+
+void VirtualClock::runDueActions(uint32_t now)
+{
+   // Actions may schedule further actions. Thus, we pick them one by one.
+   //
+   while(!scheduled_actions_.empty()) {
+      auto it = scheduled_actions_.begin();
+      if(it->first > now) { break; }
+      auto action = std::move(it->second);
+      scheduled_actions_.erase(it);
+      action();
+   }
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
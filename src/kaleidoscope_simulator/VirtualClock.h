@@ -0,0 +1,100 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief A scheduler that knows about upcoming time-dependent events.
+/// @details The virtual clock keeps track of two types of deadlines.
+///        Test actions that are scheduled for a given point in time
+///        and deadline providers. The latter are queried for the next
+///        point in time at which the firmware is expected to react
+///        on time passing, e.g. a pending plugin timeout or the next frame
+///        of an LED effect.
+///
+class VirtualClock
+{
+   public:
+
+      /// @brief A function that determines the next deadline.
+      /// @details The function is passed the current time and must
+      ///        return true and assign the deadline if there is
+      ///        a deadline pending.
+      ///
+      typedef std::function<bool(uint32_t now, uint32_t &deadline)> DeadlineProvider;
+
+      /// @brief An action that is executed at a given point in time.
+      ///
+      typedef std::function<void()> ScheduledAction;
+
+      /// @brief Schedules an action to be executed at a given time.
+      /// @param time The time [ms] at which the action is due.
+      /// @param action The action to execute.
+      ///
+      void scheduleAt(uint32_t time, ScheduledAction action) {
+         scheduled_actions_.emplace(time, std::move(action));
+      }
+
+      /// @brief Registers a provider of deadlines.
+      /// @param provider The deadline provider.
+      ///
+      void addDeadlineProvider(DeadlineProvider provider) {
+         deadline_providers_.push_back(std::move(provider));
+      }
+
+      /// @brief Registers a deadline that repeats with a fixed period.
+      /// @details Use this e.g. to have LED effect frames as deadlines.
+      /// @param period The period [ms].
+      /// @param phase The time [ms] of one of the deadlines.
+      ///
+      void addPeriodicDeadline(uint32_t period, uint32_t phase = 0);
+
+      /// @brief Removes all scheduled actions and deadline providers.
+      ///
+      void clear() {
+         scheduled_actions_.clear();
+         deadline_providers_.clear();
+      }
+
+      /// @brief Determines the next deadline after a given time.
+      /// @param now The current time [ms].
+      /// @param deadline The next deadline [ms] if there is any.
+      /// @returns True if there is a deadline after now.
+      ///
+      bool getNextDeadline(uint32_t now, uint32_t &deadline) const;
+
+      /// @brief Executes all scheduled actions that are due.
+      /// @param now The current time [ms].
+      ///
+      void runDueActions(uint32_t now);
+
+   private:
+
+      std::multimap<uint32_t, ScheduledAction> scheduled_actions_;
+      std::vector<DeadlineProvider> deadline_providers_;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
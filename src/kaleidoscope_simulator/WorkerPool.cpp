@@ -0,0 +1,251 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kaleidoscope_simulator/WorkerPool.h"
+#include "kaleidoscope_simulator/aux/exceptions.h"
+
+#include <stdio.h>
+#include <iostream>
+
+#ifdef __unix__
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+namespace kaleidoscope {
+namespace simulator {
+   
+#ifdef __unix__
+
+namespace {
+   
+struct Worker {
+   pid_t pid;
+   int fd;
+   size_t job_id;
+};
+
+// Writes a job's output to the pipe, retrying on partial writes.
+//
+bool writeAll(int fd, const std::string &s)
+{
+   const char *data = s.data();
+   size_t remaining = s.size();
+   
+   while(remaining > 0) {
+      ssize_t n = ::write(fd, data, remaining);
+      if(n < 0) {
+         if(errno == EINTR) { continue; }
+         return false;
+      }
+      data += n;
+      remaining -= n;
+   }
+   return true;
+}
+
+// Runs in the forked child and never returns.
+//
+void runWorker(int fd, size_t job_id, const WorkerPool::Job &job, 
+               bool silence)
+{
+   if(silence) {
+      int null_fd = ::open("/dev/null", O_WRONLY);
+      if(null_fd >= 0) {
+         ::dup2(null_fd, STDOUT_FILENO);
+         ::close(null_fd);
+      }
+   }
+   
+   int status = 0;
+   std::string output;
+   
+   try {
+      output = job(job_id);
+   }
+   catch(const std::exception &e) {
+      output = e.what();
+      status = 1;
+   }
+   catch(...) {
+      output = "Unknown exception";
+      status = 1;
+   }
+   
+   std::cout.flush();
+   fflush(nullptr);
+   
+   if(!writeAll(fd, output)) {
+      status = 2;
+   }
+   
+   // Leave without running static destructors or atexit handlers.
+   // They belong to the parent process.
+   //
+   _exit(status);
+}
+
+// Kills and reaps workers that are still running and closes
+// their pipes.
+//
+void abortWorkers(std::vector<Worker> &workers)
+{
+   for(const auto &worker: workers) {
+      ::kill(worker.pid, SIGKILL);
+      ::close(worker.fd);
+   }
+   for(const auto &worker: workers) {
+      while(waitpid(worker.pid, nullptr, 0) < 0 && errno == EINTR) {}
+   }
+   workers.clear();
+}
+
+} // namespace
+
+   WorkerPool
+      ::WorkerPool(unsigned max_workers)
+   :  max_workers_(max_workers)
+{
+   if(max_workers_ == 0) {
+      long n = sysconf(_SC_NPROCESSORS_ONLN);
+      max_workers_ = (n > 0) ? unsigned(n) : 1;
+   }
+}
+
+std::vector<WorkerPool::Result> WorkerPool::run(size_t n_jobs, const Job &job)
+{
+   std::vector<Result> results(n_jobs);
+   std::vector<Worker> workers;
+   std::vector<struct pollfd> poll_fds;
+   
+   size_t next_job = 0;
+   char buffer[4096];
+   
+   // A forked worker must be registered without risking an exception.
+   //
+   workers.reserve(max_workers_);
+   
+   // Buffered output would otherwise be written once more 
+   // by every child.
+   //
+   std::cout.flush();
+   fflush(nullptr);
+   
+   // Workers that are already running must not outlive a failure.
+   //
+   try {
+      while(next_job < n_jobs || !workers.empty()) {
+         
+         while(next_job < n_jobs && workers.size() < max_workers_) {
+            
+            int fds[2];
+            if(pipe(fds) != 0) {
+               KS_T_EXCEPTION("Unable to create worker pipe: " << strerror(errno))
+            }
+            
+            pid_t pid = fork();
+            if(pid < 0) {
+               int error = errno;
+               ::close(fds[0]);
+               ::close(fds[1]);
+               KS_T_EXCEPTION("Unable to fork worker process: " << strerror(error))
+            }
+            
+            if(pid == 0) {
+               ::close(fds[0]);
+               for(const auto &worker: workers) {
+                  ::close(worker.fd);
+               }
+               runWorker(fds[1], next_job, job, silence_workers_);
+            }
+            
+            ::close(fds[1]);
+            workers.push_back(Worker{pid, fds[0], next_job});
+            ++next_job;
+         }
+         
+         poll_fds.clear();
+         for(const auto &worker: workers) {
+            poll_fds.push_back(pollfd{worker.fd, POLLIN, 0});
+         }
+         
+         if(poll(poll_fds.data(), poll_fds.size(), -1) < 0) {
+            if(errno == EINTR) { continue; }
+            KS_T_EXCEPTION("Unable to wait for worker processes: " << strerror(errno))
+         }
+         
+         // Iterate backwards as finished workers are removed.
+         //
+         for(size_t i = poll_fds.size(); i-- > 0; ) {
+            
+            if(poll_fds[i].revents == 0) { continue; }
+            
+            auto &worker = workers[i];
+            ssize_t n = ::read(worker.fd, buffer, sizeof(buffer));
+            
+            if(n > 0) {
+               results[worker.job_id].output.append(buffer, n);
+               continue;
+            }
+            if(n < 0 && errno == EINTR) { continue; }
+            
+            // End of output, the worker is done.
+            //
+            ::close(worker.fd);
+            
+            int status = 0;
+            while(waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {}
+            
+            results[worker.job_id].success 
+               = WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+               
+            workers.erase(workers.begin() + i);
+         }
+      }
+   }
+   catch(...) {
+      abortWorkers(workers);
+      throw;
+   }
+   
+   return results;
+}
+
+#else
+
+   WorkerPool
+      ::WorkerPool(unsigned max_workers)
+   :  max_workers_(max_workers ? max_workers : 1)
+{
+}
+
+std::vector<WorkerPool::Result> WorkerPool::run(size_t n_jobs, const Job &job)
+{
+   KS_T_EXCEPTION("Worker processes are not supported on this platform")
+}
+
+#endif
+
+} // namespace simulator
+} // namespace kaleidoscope
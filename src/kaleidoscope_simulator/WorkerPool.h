@@ -0,0 +1,104 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief Runs jobs concurrently in forked worker processes.
+/// @details The firmware keeps its entire state in static storage. 
+///        Thus, concurrent simulations must live in separate processes.
+///        Every job is run in a child process that is forked from 
+///        the calling process. It starts with an exact copy of 
+///        the caller's state, including the firmware's state,
+///        and can not affect the caller in any way. 
+///
+///        A job returns a string that is sent back to the caller 
+///        through a pipe. Results are returned in the order of
+///        the jobs, regardless of the order in which the workers finish.
+///
+///        Only available on unix platforms.
+///
+class WorkerPool
+{
+   public:
+      
+      /// @brief The function that implements a job.
+      /// @details Exceptions thrown by a job are reported as failure
+      ///        of the job.
+      /// @param job_id The index of the job.
+      /// @returns The output of the job.
+      ///
+      typedef std::function<std::string(size_t job_id)> Job;
+      
+      /// @brief The outcome of a job.
+      ///
+      struct Result {
+         
+         /// @brief True if the job returned regularly.
+         ///
+         bool success = false;
+         
+         /// @brief The string returned by the job or the
+         ///        message of the exception that it threw.
+         ///
+         std::string output;
+      };
+      
+      /// @brief Constructor.
+      /// @param max_workers The max. number of concurrent worker processes.
+      ///        Zero selects the number of online processors.
+      ///
+      explicit WorkerPool(unsigned max_workers = 0);
+      
+      /// @brief Retreives the max. number of concurrent worker processes.
+      ///
+      unsigned getMaxWorkers() const { return max_workers_; }
+      
+      /// @brief Enables or disables silencing of workers.
+      /// @details The standard output of silenced workers is discarded.
+      ///        This prevents the output of concurrent workers from 
+      ///        being interleaved. Workers are silenced by default.
+      /// @param state The enable state.
+      ///
+      void setSilenceWorkers(bool state) { silence_workers_ = state; }
+      
+      /// @brief Runs a number of jobs.
+      /// @details Blocks until all jobs are finished. 
+      ///        Throws if a worker process can not be created.
+      /// @param n_jobs The number of jobs.
+      /// @param job The function that is called with the index
+      ///        of every job in a worker process.
+      /// @returns The results of all jobs, in the order of their indices.
+      ///
+      std::vector<Result> run(size_t n_jobs, const Job &job);
+      
+   private:
+      
+      unsigned max_workers_ = 1;
+      bool silence_workers_ = true;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,149 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard 
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "papilio/actions/Action_.h"
+
+#include "kaleidoscope_simulator/Simulator.h"
+#include "kaleidoscope_simulator/HIDUsageTable.h"
+#include "kaleidoscope_simulator/reports/KeycodeSet.h"
+
+#include "kaleidoscope/key_defs.h"
+
+#include <initializer_list>
+
+namespace kaleidoscope {
+namespace simulator {
+namespace actions {
+   
+/// @brief The direction of a keycode change.
+///
+enum class KeycodeChange {
+   pressed,
+   released
+};
+   
+/// @brief Asserts that given keycodes were pressed or released with the
+///        current keyboard report.
+/// @details The keycodes are checked against the report delta
+///        (see Simulator::getReportDelta()). Modifiers and
+///        other keycodes can be mixed. The assertion fails
+///        if the delta does not belong to a keyboard report.
+///
+///        Queue the assertion as a report action. Evaluated anywhere
+///        else, it refers to the last report that was emitted.
+///
+///        Use the aliases AssertKeycodesPressed and AssertKeycodesReleased.
+///
+template<KeycodeChange _change>
+class AssertKeycodesChanged {
+   
+   public:
+      
+      /// @brief Constructor.
+      /// @param keys The keys whose keycodes must have been pressed
+      ///        or released for the action to pass.
+      ///
+      AssertKeycodesChanged(std::initializer_list<Key> keys) 
+         : AssertKeycodesChanged(DelegateConstruction{}, keys) 
+      {}
+   
+   private:
+      
+      class Action : public papilio::Action_ {
+   
+         public:
+
+            Action(std::initializer_list<Key> keys) {
+               for(const auto &key: keys) {
+                  keycodes_.insert(key.getKeyCode());
+               }
+            }
+
+            virtual void describe(const char *add_indent = "") const override {
+               auto out = this->getSimulator()->log();
+               out << add_indent << "Keycodes " 
+                  << ((_change == KeycodeChange::pressed) ? "pressed" : "released") << ':';
+               for(auto keycode: keycodes_) {
+                  const char *dump_name = getHIDUsage(keycode).dump_name;
+                  out << ' ' << ((dump_name) ? dump_name : "(other)");
+               }
+            }
+
+            virtual void describeState(const char *add_indent = "") const {
+               auto simulator = Simulator::getActive();
+               if(!simulator) { return; }
+               
+               const auto &delta = simulator->getReportDelta();
+               
+               if(!isKeyboardDelta(delta)) {
+                  simulator->log() << add_indent << "No keyboard report";
+                  return;
+               }
+               
+               delta.dump(*simulator, add_indent);
+            }
+
+            virtual bool evalInternal() override {
+               auto simulator = Simulator::getActive();
+               if(!simulator) { return false; }
+               
+               const auto &delta = simulator->getReportDelta();
+               
+               if(!isKeyboardDelta(delta)) { return false; }
+               
+               if(_change == KeycodeChange::pressed) {
+                  return (keycodes_ 
+                           - delta.getPressedKeycodes()
+                           - delta.getPressedModifiers()).empty();
+               }
+               
+               return (keycodes_ 
+                        - delta.getReleasedKeycodes()
+                        - delta.getReleasedModifiers()).empty();
+            }
+            
+         private:
+            
+            static bool isKeyboardDelta(const ReportDelta &delta) {
+               return (delta.getType() == HIDReportType::keyboard)
+                   || (delta.getType() == HIDReportType::boot_keyboard);
+            }
+            
+         private:
+            
+            KeycodeSet keycodes_;
+      };
+   
+   PAPILIO_AUTO_DEFINE_ACTION_INVENTORY_TMPL(AssertKeycodesChanged<_change>)
+};
+
+/// @brief Asserts that given keycodes were pressed with the
+///        current keyboard report.
+///
+typedef AssertKeycodesChanged<KeycodeChange::pressed> AssertKeycodesPressed;
+
+/// @brief Asserts that given keycodes were released with the
+///        current keyboard report.
+///
+typedef AssertKeycodesChanged<KeycodeChange::released> AssertKeycodesReleased;
+   
+} // namespace actions
+} // namespace simulator
+} // namespace kaleidoscope
@@ -20,15 +20,14 @@
 #include "kaleidoscope_simulator/reports/KeyboardReport.h"
 #include "kaleidoscope_simulator/reports/MouseReport.h"
 #include "kaleidoscope_simulator/reports/AbsoluteMouseReport.h"
+#include "kaleidoscope_simulator/HIDUsageTable.h"
+#include "kaleidoscope_simulator/Simulator.h"
 #include "papilio/Simulator.h"
 
 #ifdef __unix__ /* __unix__ is usually defined by compilers targeting Unix systems */
 
 #include <X11/extensions/XTest.h>
 #include <unistd.h>
-#include <linux/input-event-codes.h>
-
-#include <set>
 
 // see /usr/include/linux/input-event-codes.h
 // and /usr/share/X11/xkb/keycodes/evdev
@@ -51,188 +50,50 @@ namespace actions {
 }
    
 namespace {
-unsigned const int modifiers[] = {
-   KEY_LEFTCTRL, KEY_LEFTSHIFT, KEY_LEFTALT, KEY_LEFTMETA,
-      KEY_RIGHTCTRL, KEY_RIGHTSHIFT, KEY_RIGHTALT, KEY_RIGHTMETA 
-};
+// X11 keycodes are Linux keycodes offset by 8.
+//
+inline unsigned int getX11Keycode(uint8_t hid_keycode) {
+   return getHIDUsage(hid_keycode).linux_keycode + 8;
+}
    
-unsigned const int keycodes[][8] = {
-   { 0, 0, 0, 0, KEY_A, KEY_B, KEY_C, KEY_D },
-   { KEY_E, KEY_F, KEY_G, KEY_H, KEY_I, KEY_J, KEY_K, KEY_L },
-   { KEY_M, KEY_N, KEY_O, KEY_P, KEY_Q, KEY_R, KEY_S, KEY_T },
-   { KEY_U, KEY_V, KEY_W, KEY_X, KEY_Y, KEY_Z, KEY_1, KEY_2 },
-   { KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8, KEY_9, KEY_0 },
-   { KEY_ENTER, KEY_ESC, KEY_BACKSPACE, KEY_TAB, KEY_SPACE, KEY_MINUS, KEY_EQUAL, KEY_LEFTBRACE },
-   { KEY_RIGHTBRACE, KEY_BACKSLASH, KEY_BACKSLASH, KEY_SEMICOLON, KEY_APOSTROPHE, KEY_GRAVE, KEY_COMMA, KEY_DOT },
-   { KEY_SLASH, KEY_CAPSLOCK, KEY_F1, KEY_F2, KEY_F3, KEY_F4, KEY_F5, KEY_F6 },
-   { KEY_F7, KEY_F8, KEY_F9, KEY_F10, KEY_F11, KEY_F12, KEY_SYSRQ, KEY_SCROLLLOCK },
-   { KEY_PAUSE, KEY_INSERT, KEY_HOME, KEY_PAGEUP, KEY_DELETE, KEY_END, KEY_PAGEDOWN, KEY_RIGHT },
-   { KEY_LEFT, KEY_DOWN, KEY_UP, KEY_NUMLOCK, KEY_KPSLASH, KEY_KPASTERISK, KEY_KPMINUS, KEY_KPPLUS },
-   { KEY_KPENTER, KEY_KP1, KEY_KP2, KEY_KP3, KEY_KP4, KEY_KP5, KEY_KP6, KEY_KP7 },
-   { KEY_KP8, KEY_KP9, KEY_KP0, KEY_KPDOT, KEY_SLASH, KEY_APPSELECT, KEY_POWER, KEY_KPEQUAL },
-   { KEY_F13, KEY_F14, KEY_F15, KEY_F16, KEY_F17, KEY_F18, KEY_F19, KEY_F20 },
-   { KEY_F21, KEY_F22, KEY_F23, KEY_F24, KEY_OPEN, KEY_HELP, KEY_MENU, KEY_SELECT },
-   { KEY_STOP, KEY_AGAIN, KEY_UNDO, KEY_CUT, KEY_COPY, KEY_PASTE, KEY_FIND, KEY_MUTE },
-   { KEY_VOLUMEUP, KEY_VOLUMEDOWN, KEY_UNKNOWN, KEY_UNKNOWN, KEY_UNKNOWN, KEY_UNKNOWN, KEY_UNKNOWN, KEY_UNKNOWN }
-};
+// HID usages without Linux keycode can not be passed on to X11.
+//
+inline bool hasX11Keycode(uint8_t hid_keycode) {
+   return getHIDUsage(hid_keycode).linux_keycode != 0;
+}
 
-class KeyboardReportEventCheck {
+inline void fakeKeyEvent(Display *display, uint8_t hid_keycode, bool is_pressed) {
    
-   public:
-      
-      KeyboardReportEventCheck(const papilio::Simulator &simulator,
-                    Display *display,
-                    const KeyboardReport &previous_report, 
-                    const KeyboardReport &current_report)
-      :  simulator_{simulator},
-         display_{display},
-         previous_report_data_{previous_report.getReportData()},
-         current_report_data_{current_report.getReportData()}
-      {}
-      
-      void compareReports() {
-            
-         for(int j = 0; j < 8; ++j) {
-            this->modifierCheck(j);
-         }
-         
-         for(int i = 0; i < 17; ++i) {
-            for(int j = 0; j < 8; ++j) {
-               this->keyCheck(i, j);
-            }
-         }
-      }
-      
-   private:
-      
-      void modifierCheck(int j)
-      {   
-         auto old_state = bitRead(previous_report_data_.modifiers, j);
-         auto new_state = bitRead(current_report_data_.modifiers, j);
-         
-         if(old_state == new_state) { return; }
-         
-         auto keycode = modifiers[j] + 8;
-         
-         bool is_pressed = (new_state) ? true : false;
-         
-         XTestFakeKeyEvent(display_, keycode, is_pressed, CurrentTime);
-      }
-      
-      void keyCheck(int i, int j)
-      {   
-         auto old_state = bitRead(previous_report_data_.keys[i], j);
-         auto new_state = bitRead(current_report_data_.keys[i], j);
-         
-         if(old_state == new_state) { return; }
-         
-         auto keycode = keycodes[i][j] + 8;
-         
-         bool is_pressed = (new_state) ? true : false;
-         
-         //simulator_.debug() << "Generating system keycode " << keycode << " (pressed = " << is_pressed << ")";
-         XTestFakeKeyEvent(display_, keycode, is_pressed, CurrentTime);
-      }
-      
-   private:
-      
-      const papilio::Simulator &simulator_;
-      Display *display_;
-      const KeyboardReport::ReportDataType &previous_report_data_;
-      const KeyboardReport::ReportDataType &current_report_data_;
-};
+   // Keys without a Linux keycode are ignored.
+   //
+   if(!hasX11Keycode(hid_keycode)) { return; }
+   
+   XTestFakeKeyEvent(display, getX11Keycode(hid_keycode), is_pressed, CurrentTime);
+}
 
-class BootKeyboardReportEventCheck {
+// Generates key events for all keycodes that changed with 
+// the report that is currently processed.
+//
+void generateKeyEvents(Display *display)
+{
+   auto simulator = Simulator::getActive();
+   if(!simulator) { return; }
    
-   public:
-      
-      BootKeyboardReportEventCheck(const papilio::Simulator &simulator,
-                    Display *display,
-                    const BootKeyboardReport &previous_report, 
-                    const BootKeyboardReport &current_report)
-      :  simulator_{simulator},
-         display_{display},
-         previous_report_data_{previous_report.getReportData()},
-         current_report_data_{current_report.getReportData()}
-      {
-      }
-      
-      void compareReports() {
-            
-         for(int j = 0; j < 8; ++j) {
-            this->modifierCheck(j);
-         }
-         
-         this->keyCheck();
-      }
-      
-   private:
-      
-      void modifierCheck(int j)
-      {   
-         auto old_state = bitRead(previous_report_data_.modifiers, j);
-         auto new_state = bitRead(current_report_data_.modifiers, j);
-         
-         if(old_state == new_state) { return; }
-         
-         auto keycode = modifiers[j] + 8;
-         
-         bool is_pressed = (new_state) ? true : false;
-         
-         XTestFakeKeyEvent(display_, keycode, is_pressed, CurrentTime);
-      }
-      
-      void keyCheck()
-      {   
-         std::set<uint8_t> previous_report_keycodes,
-                           current_report_keycodes;
-      
-         for(int i = 0; i < 6; ++i) {
-            if(previous_report_data_.keycodes[i] != 0) {
-               previous_report_keycodes.insert(
-                  previous_report_data_.keycodes[i]
-               );
-            }
-            if(current_report_data_.keycodes[i] != 0) {
-               current_report_keycodes.insert(
-                  current_report_data_.keycodes[i]
-               );
-            }
-         }
-         
-         for(const auto &k: previous_report_keycodes) {
-            if(current_report_keycodes.find(k) == current_report_keycodes.end()) {
-               
-               auto actual_keycode = getActualKeycode(k);
-               
-               // Keycode only present in previous report 
-               // => key released
-               XTestFakeKeyEvent(display_, actual_keycode, False, CurrentTime);
-            }
-         }
-         for(const auto &k: current_report_keycodes) {
-            if(previous_report_keycodes.find(k) == previous_report_keycodes.end()) {
-               
-               auto actual_keycode = getActualKeycode(k);
-               
-               // Keycode only present in current report 
-               // => key pressed
-               XTestFakeKeyEvent(display_, actual_keycode, True, CurrentTime);
-            }
-         }
-      }
-      
-      static uint8_t getActualKeycode(uint8_t k) {
-         return keycodes[k/8][k%8] + 8;
-      }
-      
-   private:
-      
-      const papilio::Simulator &simulator_;
-      Display *display_;
-      const BootKeyboardReport::ReportDataType &previous_report_data_;
-      const BootKeyboardReport::ReportDataType &current_report_data_;
-};
+   const auto &delta = simulator->getReportDelta();
+   
+   for(auto keycode: delta.getReleasedModifiers()) {
+      fakeKeyEvent(display, keycode, false);
+   }
+   for(auto keycode: delta.getPressedModifiers()) {
+      fakeKeyEvent(display, keycode, true);
+   }
+   for(auto keycode: delta.getReleasedKeycodes()) {
+      fakeKeyEvent(display, keycode, false);
+   }
+   for(auto keycode: delta.getPressedKeycodes()) {
+      fakeKeyEvent(display, keycode, true);
+   }
+}
 
 } // namespace
 
@@ -241,20 +102,10 @@ bool GenerateHostEvent<BootKeyboardReport>::Action::evalInternal()
 {
    auto d = static_cast<Display*>(display_);
    
-   BootKeyboardReportEventCheck{
-      *this->getSimulator(),
-      d,
-      *previous_report_, 
-      static_cast<const BootKeyboardReport&>(this->getReport())
-   }.compareReports();
+   generateKeyEvents(d);
    
    XSync(d, 0);
    
-   this->cachePreviousReport();
-
-   // We ignore any further key bytes in the report as we do not have
-   // any defined keycodes for those.
-   
    return true;
 }
 
@@ -263,20 +114,10 @@ bool GenerateHostEvent<KeyboardReport>::Action::evalInternal()
 {
    auto d = static_cast<Display*>(display_);
    
-   KeyboardReportEventCheck{
-      *this->getSimulator(),
-      d,
-      *previous_report_, 
-      static_cast<const KeyboardReport&>(this->getReport())
-   }.compareReports();
+   generateKeyEvents(d);
    
    XSync(d, 0);
    
-   this->cachePreviousReport();
-
-   // We ignore any further key bytes in the report as we do not have
-   // any defined keycodes for those.
-   
    return true;
 }
 
@@ -67,17 +67,6 @@ class GenerateHostEvent
             }
 
             virtual bool evalInternal() override;
-            
-         private:
-         
-            void cachePreviousReport() {
-               previous_report_ 
-                  = std::static_pointer_cast<_ReportType>(this->getReport().clone());
-            }
-            
-         private:
-            
-            std::shared_ptr<_ReportType> previous_report_;
       };
    
    PAPILIO_AUTO_DEFINE_ACTION_INVENTORY_TMPL(GenerateHostEvent<_ReportType>)
@@ -18,7 +18,8 @@
 #pragma once
 
 #include <sstream>
-#include <exception>
+#include <string>
+#include <stdexcept>
 
 namespace kaleidoscope {
 namespace simulator {
@@ -30,7 +31,7 @@ struct OStringStreamWrapper
    template<typename _T>
    OStringStreamWrapper &operator<<(const _T &t) { osstream_ << t; return *this; }
    
-   operator const char *() { return osstream_.str().c_str(); }
+   operator std::string() const { return osstream_.str(); }
    
    std::ostringstream osstream_;
 };
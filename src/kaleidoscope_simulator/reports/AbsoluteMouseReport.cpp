@@ -19,6 +19,8 @@
 #include "kaleidoscope_simulator/reports/AbsoluteMouseReport.h"
 #include "papilio/Simulator.h"
 
+#include <typeinfo>
+
 namespace kaleidoscope {
 namespace simulator {
    
@@ -51,15 +53,14 @@ AbsoluteMouseReport &AbsoluteMouseReport::operator=(const AbsoluteMouseReport &o
 
 std::shared_ptr<papilio::Report_> AbsoluteMouseReport::clone() const
 {
-   return std::shared_ptr<papilio::Report_>{ new AbsoluteMouseReport{*this} };
+   return makePooledReport<AbsoluteMouseReport>(*this);
 }
 
 bool AbsoluteMouseReport::equals(const papilio::Report_ &other) const
 {
-   const AbsoluteMouseReport *other_amr =
-      dynamic_cast<const AbsoluteMouseReport *>(&other);
-      
-   if(!other_amr) { return false; }
+   if(typeid(other) != typeid(AbsoluteMouseReport)) { return false; }
+   
+   const AbsoluteMouseReport *other_amr = static_cast<const AbsoluteMouseReport *>(&other);
    
    return memcmp(&report_data_, &other_amr->report_data_, sizeof(report_data_)) == 0;
 }
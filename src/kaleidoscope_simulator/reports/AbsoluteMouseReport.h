@@ -20,6 +20,7 @@
 
 #include "DeviceAPIs/AbsoluteMouseAPI.h"
 #include "papilio/reports/AbsoluteMouseReport_.h"
+#include "kaleidoscope_simulator/reports/ReportPool.h"
 
 // Undefine some macros defined by Arduino
 //
@@ -37,7 +38,7 @@ class Simulator;
   
 /// @brief An interface hat facilitates analyzing absolute mouse reports.
 ///
-class AbsoluteMouseReport : public papilio::AbsoluteMouseReport_ {
+class AbsoluteMouseReport final : public papilio::AbsoluteMouseReport_ {
    
    public:
       
@@ -64,9 +65,7 @@ class AbsoluteMouseReport : public papilio::AbsoluteMouseReport_ {
       
       template<typename..._Args>
       static std::shared_ptr<AbsoluteMouseReport> create(_Args &&... args) {
-         return std::shared_ptr<AbsoluteMouseReport>{
-            new AbsoluteMouseReport{std::forward<_Args>(args)...}
-         };
+         return makePooledReport<AbsoluteMouseReport>(std::forward<_Args>(args)...);
       }
       
       AbsoluteMouseReport &operator=(const AbsoluteMouseReport &other);
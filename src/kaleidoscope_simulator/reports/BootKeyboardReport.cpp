@@ -24,11 +24,13 @@
 
 #include "kaleidoscope_simulator/reports/BootKeyboardReport.h"
 #include "kaleidoscope_simulator/aux/exceptions.h"
+#include "kaleidoscope_simulator/HIDUsageTable.h"
 #include "papilio/Simulator.h"
 #include "papilio/SimulatorCore_.h"
 #include "MultiReport/Keyboard.h"
 
 #include <vector>
+#include <typeinfo>
 
 namespace kaleidoscope {
 namespace simulator {
@@ -56,17 +58,16 @@ namespace simulator {
 
 std::shared_ptr<papilio::Report_> BootKeyboardReport::clone() const
 {
-   return std::shared_ptr<papilio::Report_>{ new BootKeyboardReport{*this} };
+   return makePooledReport<BootKeyboardReport>(*this);
 }
 
 bool 
    BootKeyboardReport
       ::equals(const papilio::Report_ &other) const
 {   
-   const BootKeyboardReport *other_bkr =
-      dynamic_cast<const BootKeyboardReport *>(&other);
-      
-   if(!other_bkr) { return false; }
+   if(typeid(other) != typeid(BootKeyboardReport)) { return false; }
+   
+   const BootKeyboardReport *other_bkr = static_cast<const BootKeyboardReport *>(&other);
    
    return memcmp(&report_data_, &other_bkr->report_data_, sizeof(report_data_)) == 0;
 }
@@ -153,6 +154,27 @@ std::vector<uint8_t>
    return activeModifiers;
 }
 
+KeycodeSet
+   BootKeyboardReport
+      ::getActiveKeycodeSet() const
+{
+   KeycodeSet keycodes;
+   for(int i = 0; i < 6; ++i) {
+      if(report_data_.keycodes[i] != 0) {
+         keycodes.insert(report_data_.keycodes[i]);
+      }
+   }
+   
+   return keycodes;
+}
+
+KeycodeSet
+   BootKeyboardReport
+      ::getActiveModifierSet() const
+{
+   return KeycodeSet::fromBitmap(&report_data_.modifiers, 1, HID_KEYBOARD_FIRST_MODIFIER);
+}
+
 bool  
    BootKeyboardReport
       ::isEmpty() const
@@ -167,16 +189,6 @@ void
    memcpy(&report_data_, &report_data, sizeof(report_data_));
 }
 
-// For each bit set in 'bitfield', output the corresponding string to 'stream'
-#define FOREACHBIT(bitfield, stream, str0, str1, str2, str3, str4, str5, str6, str7) \
-  if((bitfield) & 1<<0) stream << str0; \
-  if((bitfield) & 1<<1) stream << str1; \
-  if((bitfield) & 1<<2) stream << str2; \
-  if((bitfield) & 1<<3) stream << str3; \
-  if((bitfield) & 1<<4) stream << str4; \
-  if((bitfield) & 1<<5) stream << str5; \
-  if((bitfield) & 1<<6) stream << str6; \
-  if((bitfield) & 1<<7) stream << str7;
 void
    BootKeyboardReport
       ::dump(const papilio::Simulator &simulator, const char *add_indent) const
@@ -202,10 +214,11 @@ void
       out << add_indent << "<none>";
    } else {
       out << add_indent;
-      FOREACHBIT(report_data_.modifiers, out,
-        "lctrl ", "lshift ", "lalt ", "lgui ",
-        "rctrl ", "rshift ", "ralt ", "rgui ")
-
+      for(uint8_t m = 0; m < 8; ++m) {
+         if(report_data_.modifiers & (1 << m)) {
+            out << getHIDUsage(HID_KEYBOARD_FIRST_MODIFIER + m).dump_name << ' ';
+         }
+      }
       for(int i = 0; i < 6; ++i) {
          if(report_data_.keycodes[i] != 0) {
             out << simulator.getCore().keycodeToName(report_data_.keycodes[i]) << ' ';
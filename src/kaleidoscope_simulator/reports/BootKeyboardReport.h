@@ -20,6 +20,8 @@
 
 #include "kaleidoscope/key_defs.h"
 #include "papilio/reports/BootKeyboardReport_.h"
+#include "kaleidoscope_simulator/reports/ReportPool.h"
+#include "kaleidoscope_simulator/reports/KeycodeSet.h"
 #include "BootKeyboard/BootKeyboard.h"
 
 // Undefine some macros defined by Arduino
@@ -38,7 +40,7 @@ class Simulator;
   
 /// @brief An interface hat facilitates analyzing boot keyboard reports.
 ///
-class BootKeyboardReport : public papilio::BootKeyboardReport_ {
+class BootKeyboardReport final : public papilio::BootKeyboardReport_ {
    
    public:
       
@@ -64,9 +66,7 @@ class BootKeyboardReport : public papilio::BootKeyboardReport_ {
       
       template<typename..._Args>
       static std::shared_ptr<BootKeyboardReport> create(_Args &&... args) {
-         return std::shared_ptr<BootKeyboardReport>{
-            new BootKeyboardReport{std::forward<_Args>(args)...}
-         };
+         return makePooledReport<BootKeyboardReport>(std::forward<_Args>(args)...);
       }
       
       virtual std::shared_ptr<papilio::Report_> clone() const override;
@@ -110,6 +110,15 @@ class BootKeyboardReport : public papilio::BootKeyboardReport_ {
       ///
       virtual std::vector<uint8_t> getActiveModifiers() const override;
       
+      /// @brief Retreives the set of all keycodes that are active in the
+      ///        keyboard report.
+      ///
+      KeycodeSet getActiveKeycodeSet() const;
+      
+      /// @brief Retreives the set of active modifier keycodes.
+      ///
+      KeycodeSet getActiveModifierSet() const;
+      
       /// @brief Checks if the report is empty.
       /// @details Empty means neither key nor modifier keycodes are active.
       ///
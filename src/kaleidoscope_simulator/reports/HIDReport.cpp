@@ -0,0 +1,197 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Important: Leave stdint.h the first header as some other Kaleidoscope
+//            related stuff depends on standard integer types to be defined
+//            (Arduino defines them auto-magically).
+//
+#include <stdint.h>
+
+#include "kaleidoscope_simulator/reports/HIDReport.h"
+#include "papilio/Simulator.h"
+#include "HID-Settings.h"
+
+#include <string.h>
+
+namespace kaleidoscope {
+namespace simulator {
+
+   HIDReport
+      ::HIDReport(uint8_t id, const void *data)
+   :  type_(typeFromId(id))
+{
+   switch(type_) {
+      case HIDReportType::boot_keyboard:
+         new (&boot_keyboard_) BootKeyboardReport{data};
+         break;
+      case HIDReportType::keyboard:
+         new (&keyboard_) KeyboardReport{data};
+         break;
+      case HIDReportType::mouse:
+         new (&mouse_) MouseReport{data};
+         break;
+      case HIDReportType::absolute_mouse:
+         new (&absolute_mouse_) AbsoluteMouseReport{data};
+         break;
+      case HIDReportType::none:
+         break;
+   }
+}
+
+HIDReportType HIDReport::typeFromId(uint8_t id)
+{
+   switch(id) {
+      case HID_REPORTID_KEYBOARD:
+         return HIDReportType::boot_keyboard;
+      case HID_REPORTID_NKRO_KEYBOARD:
+         return HIDReportType::keyboard;
+      case HID_REPORTID_MOUSE:
+         return HIDReportType::mouse;
+      case HID_REPORTID_MOUSE_ABSOLUTE:
+         return HIDReportType::absolute_mouse;
+   }
+   return HIDReportType::none;
+}
+
+size_t HIDReport::getDataSize(HIDReportType type)
+{
+   switch(type) {
+      case HIDReportType::boot_keyboard:
+         return sizeof(BootKeyboardReport::ReportDataType);
+      case HIDReportType::keyboard:
+         return sizeof(KeyboardReport::ReportDataType);
+      case HIDReportType::mouse:
+         return sizeof(MouseReport::ReportDataType);
+      case HIDReportType::absolute_mouse:
+         return sizeof(AbsoluteMouseReport::ReportDataType);
+      case HIDReportType::none:
+         break;
+   }
+   return 0;
+}
+
+uint8_t HIDReport::getId() const
+{
+   switch(type_) {
+      case HIDReportType::boot_keyboard:
+         return HID_REPORTID_KEYBOARD;
+      case HIDReportType::keyboard:
+         return HID_REPORTID_NKRO_KEYBOARD;
+      case HIDReportType::mouse:
+         return HID_REPORTID_MOUSE;
+      case HIDReportType::absolute_mouse:
+         return HID_REPORTID_MOUSE_ABSOLUTE;
+      case HIDReportType::none:
+         break;
+   }
+   return 0;
+}
+
+bool HIDReport::operator==(const HIDReport &other) const
+{
+   if(type_ != other.type_) { return false; }
+
+   switch(type_) {
+      case HIDReportType::boot_keyboard:
+         return memcmp(&boot_keyboard_.getReportData(), 
+                       &other.boot_keyboard_.getReportData(),
+                       sizeof(BootKeyboardReport::ReportDataType)) == 0;
+      case HIDReportType::keyboard:
+         return memcmp(&keyboard_.getReportData(), 
+                       &other.keyboard_.getReportData(),
+                       sizeof(KeyboardReport::ReportDataType)) == 0;
+      case HIDReportType::mouse:
+         return memcmp(&mouse_.getReportData(), 
+                       &other.mouse_.getReportData(),
+                       sizeof(MouseReport::ReportDataType)) == 0;
+      case HIDReportType::absolute_mouse:
+         return memcmp(&absolute_mouse_.getReportData(), 
+                       &other.absolute_mouse_.getReportData(),
+                       sizeof(AbsoluteMouseReport::ReportDataType)) == 0;
+      case HIDReportType::none:
+         break;
+   }
+   return true;
+}
+
+void HIDReport::dump(const papilio::Simulator &simulator, const char *add_indent) const
+{
+   switch(type_) {
+      case HIDReportType::boot_keyboard:
+         boot_keyboard_.dump(simulator, add_indent);
+         break;
+      case HIDReportType::keyboard:
+         keyboard_.dump(simulator, add_indent);
+         break;
+      case HIDReportType::mouse:
+         mouse_.dump(simulator, add_indent);
+         break;
+      case HIDReportType::absolute_mouse:
+         absolute_mouse_.dump(simulator, add_indent);
+         break;
+      case HIDReportType::none:
+         simulator.log() << add_indent << "Ignored HID report";
+         break;
+   }
+}
+
+void HIDReport::assign(const HIDReport &other)
+{
+   type_ = other.type_;
+   
+   switch(type_) {
+      case HIDReportType::boot_keyboard:
+         new (&boot_keyboard_) BootKeyboardReport{other.boot_keyboard_};
+         break;
+      case HIDReportType::keyboard:
+         new (&keyboard_) KeyboardReport{other.keyboard_};
+         break;
+      case HIDReportType::mouse:
+         new (&mouse_) MouseReport{other.mouse_};
+         break;
+      case HIDReportType::absolute_mouse:
+         new (&absolute_mouse_) AbsoluteMouseReport{other.absolute_mouse_};
+         break;
+      case HIDReportType::none:
+         break;
+   }
+}
+
+void HIDReport::destroy()
+{
+   switch(type_) {
+      case HIDReportType::boot_keyboard:
+         boot_keyboard_.~BootKeyboardReport();
+         break;
+      case HIDReportType::keyboard:
+         keyboard_.~KeyboardReport();
+         break;
+      case HIDReportType::mouse:
+         mouse_.~MouseReport();
+         break;
+      case HIDReportType::absolute_mouse:
+         absolute_mouse_.~AbsoluteMouseReport();
+         break;
+      case HIDReportType::none:
+         break;
+   }
+   type_ = HIDReportType::none;
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,200 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "kaleidoscope_simulator/reports/KeyboardReport.h"
+#include "kaleidoscope_simulator/reports/BootKeyboardReport.h"
+#include "kaleidoscope_simulator/reports/MouseReport.h"
+#include "kaleidoscope_simulator/reports/AbsoluteMouseReport.h"
+#include "kaleidoscope_simulator/aux/exceptions.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <new>
+#include <utility>
+
+namespace papilio {
+class Simulator;
+} // namespace papilio
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief The report types that the simulator processes.
+///
+enum class HIDReportType : uint8_t {
+   none,             ///< An ignored or unknown report.
+   boot_keyboard,
+   keyboard,
+   mouse,
+   absolute_mouse
+};
+
+/// @brief A report of any of the types the simulator processes.
+/// @details The set of report types is closed. The report is stored
+///        in place together with a type tag. Comparing, dispatching
+///        and dumping reports switches on the tag and neither needs
+///        RTTI nor virtual calls, as the report classes are final.
+///
+class HIDReport
+{
+   public:
+
+      /// @brief Default constructor.
+      /// @details Creates a report of type none.
+      ///
+      HIDReport() {}
+
+      /// @brief Constructs from raw report data.
+      /// @details Reports with unknown ids are of type none.
+      /// @param id The HID report id.
+      /// @param data The address where the report data starts.
+      ///
+      HIDReport(uint8_t id, const void *data);
+
+      /// @brief Constructs from a report object.
+      /// @param report The report to copy.
+      ///
+      HIDReport(const BootKeyboardReport &report)
+         :  type_(HIDReportType::boot_keyboard) {
+         new (&boot_keyboard_) BootKeyboardReport{report};
+      }
+      HIDReport(const KeyboardReport &report)
+         :  type_(HIDReportType::keyboard) {
+         new (&keyboard_) KeyboardReport{report};
+      }
+      HIDReport(const MouseReport &report)
+         :  type_(HIDReportType::mouse) {
+         new (&mouse_) MouseReport{report};
+      }
+      HIDReport(const AbsoluteMouseReport &report)
+         :  type_(HIDReportType::absolute_mouse) {
+         new (&absolute_mouse_) AbsoluteMouseReport{report};
+      }
+
+      HIDReport(const HIDReport &other) { this->assign(other); }
+
+      HIDReport &operator=(const HIDReport &other) {
+         if(this != &other) {
+            this->destroy();
+            this->assign(other);
+         }
+         return *this;
+      }
+
+      ~HIDReport() { this->destroy(); }
+
+      /// @brief Maps a HID report id to a report type.
+      /// @param id The HID report id.
+      /// @returns The report type or none for unknown ids.
+      ///
+      static HIDReportType typeFromId(uint8_t id);
+
+      /// @brief Retreives the size of the report data of a report type.
+      /// @param type The report type.
+      /// @returns The size in bytes, zero for type none.
+      ///
+      static size_t getDataSize(HIDReportType type);
+
+      HIDReportType getType() const { return type_; }
+
+      /// @brief Retreives the HID report id of the report.
+      /// @returns The id or zero for type none.
+      ///
+      uint8_t getId() const;
+
+      /// @brief Access the report as an object of its report class.
+      /// @details Throws if the report is not of the given class.
+      /// @tparam _ReportType The report class.
+      ///
+      template<typename _ReportType>
+      const _ReportType &get() const;
+      
+      /// @brief Calls a visitor with the report.
+      /// @details The visitor must be callable with a const reference
+      ///        to every report class. Throws for reports of type none.
+      /// @param visitor The visitor.
+      /// @returns The visitor's return value.
+      ///
+      template<typename _Visitor>
+      auto visit(_Visitor &&visitor) const
+         -> decltype(visitor(std::declval<const KeyboardReport&>()))
+      {
+         switch(type_) {
+            case HIDReportType::boot_keyboard:
+               return visitor(boot_keyboard_);
+            case HIDReportType::keyboard:
+               return visitor(keyboard_);
+            case HIDReportType::mouse:
+               return visitor(mouse_);
+            case HIDReportType::absolute_mouse:
+               return visitor(absolute_mouse_);
+            default:
+               break;
+         }
+         KS_T_EXCEPTION("Unable to visit a HID report of type none")
+      }
+
+      /// @brief Checks equality with another report.
+      /// @details Reports are equal if they are of the same type and
+      ///        their report data is equal.
+      ///
+      bool operator==(const HIDReport &other) const;
+      bool operator!=(const HIDReport &other) const { return !(*this == other); }
+
+      /// @brief Writes a formatted representation of the report
+      ///        to the simulator's log stream.
+      /// @param add_indent An additional indentation string.
+      ///
+      void dump(const papilio::Simulator &simulator, const char *add_indent = "") const;
+
+   private:
+
+      void assign(const HIDReport &other);
+      void destroy();
+
+      HIDReportType type_ = HIDReportType::none;
+
+      union {
+         BootKeyboardReport boot_keyboard_;
+         KeyboardReport keyboard_;
+         MouseReport mouse_;
+         AbsoluteMouseReport absolute_mouse_;
+      };
+};
+
+#define KALEIDOSCOPE_SIMULATOR_HID_REPORT_GET(REPORT_CLASS, TYPE, MEMBER)     \
+   template<>                                                                  \
+   inline const REPORT_CLASS &HIDReport::get<REPORT_CLASS>() const {           \
+      if(type_ != HIDReportType::TYPE) {                                       \
+         KS_T_EXCEPTION("HID report is no " << REPORT_CLASS::typeString()      \
+            << " report")                                                      \
+      }                                                                        \
+      return MEMBER;                                                           \
+   }
+
+KALEIDOSCOPE_SIMULATOR_HID_REPORT_GET(BootKeyboardReport, boot_keyboard, boot_keyboard_)
+KALEIDOSCOPE_SIMULATOR_HID_REPORT_GET(KeyboardReport, keyboard, keyboard_)
+KALEIDOSCOPE_SIMULATOR_HID_REPORT_GET(MouseReport, mouse, mouse_)
+KALEIDOSCOPE_SIMULATOR_HID_REPORT_GET(AbsoluteMouseReport, absolute_mouse, absolute_mouse_)
+
+#undef KALEIDOSCOPE_SIMULATOR_HID_REPORT_GET
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -24,9 +24,11 @@
 
 #include "kaleidoscope_simulator/reports/KeyboardReport.h"
 #include "kaleidoscope_simulator/aux/exceptions.h"
+#include "kaleidoscope_simulator/HIDUsageTable.h"
 #include "papilio/Simulator.h"
 
 #include <vector>
+#include <typeinfo>
 
 namespace kaleidoscope {
 namespace simulator {
@@ -54,17 +56,19 @@ namespace simulator {
 
 std::shared_ptr<papilio::Report_> KeyboardReport::clone() const
 {
-   return std::shared_ptr<papilio::Report_>{ new KeyboardReport{*this} };
+   return makePooledReport<KeyboardReport>(*this);
 }
       
 bool 
    KeyboardReport
       ::equals(const papilio::Report_ &other) const
 {
-   const KeyboardReport *other_kr =
-      dynamic_cast<const KeyboardReport *>(&other);
-      
-   if(!other_kr) { return false; }
+   // Report classes are final. Thus, an exact type check suffices
+   // and spares the hierarchy traversal of a dynamic_cast.
+   //
+   if(typeid(other) != typeid(KeyboardReport)) { return false; }
+   
+   const KeyboardReport *other_kr = static_cast<const KeyboardReport *>(&other);
    
    return memcmp(&report_data_, &other_kr->report_data_, sizeof(report_data_)) == 0;
 }
@@ -83,34 +87,45 @@ bool
    return false;
 }
 
+KeycodeSet
+   KeyboardReport
+      ::getActiveKeycodeSet() const
+{
+   auto keycodes = KeycodeSet::fromBitmap(report_data_.keys, sizeof(report_data_.keys));
+   
+   // The bitmap's padding bits are no keycodes.
+   //
+   keycodes.truncate(HID_LAST_KEY);
+   
+   return keycodes;
+}
+
+KeycodeSet
+   KeyboardReport
+      ::getActiveModifierSet() const
+{
+   return KeycodeSet::fromBitmap(&report_data_.modifiers, 1, HID_KEYBOARD_FIRST_MODIFIER);
+}
+
+size_t
+   KeyboardReport
+      ::getNumActiveKeycodes() const
+{
+   return this->getActiveKeycodeSet().size();
+}
+
 std::vector<uint8_t>
    KeyboardReport
       ::getActiveKeycodes() const
 {
-   std::vector<uint8_t> activeKeys;
-   
-   for(uint8_t k = 0; k <= HID_LAST_KEY; ++k) {
-      uint8_t bit = 1 << (uint8_t(k) % 8);
-      uint8_t keyCode = report_data_.keys[k / 8] & bit;
-      if(keyCode) {
-         activeKeys.push_back(k);
-      }
-   }
-   return activeKeys;
+   return this->getActiveKeycodeSet().toVector();
 }
 
 bool   
    KeyboardReport
       ::isAnyKeyActive() const
 {
-   for(int k = 0; k <= HID_LAST_KEY; ++k) {
-      uint8_t bit = 1 << (uint8_t(k) % 8);
-      if(report_data_.keys[k / 8] & bit) {
-         return true;
-      }
-   }
-   
-   return false;
+   return !this->getActiveKeycodeSet().empty();
 }
       
 bool
@@ -131,28 +146,14 @@ bool
    KeyboardReport
       ::isAssertAnyModifierActive() const
 {
-   for(uint8_t k = HID_KEYBOARD_FIRST_MODIFIER; k <= HID_KEYBOARD_LAST_MODIFIER; ++k) {
-      uint8_t kTmp = k - HID_KEYBOARD_FIRST_MODIFIER;
-      if(!!(report_data_.modifiers & (1 << kTmp))) {
-         return true;
-      }
-   }
-   return false;
+   return report_data_.modifiers != 0;
 }
 
 std::vector<uint8_t> 
    KeyboardReport
       ::getActiveModifiers() const
 {
-   std::vector<uint8_t> activeModifiers;
-   
-   for(uint8_t k = HID_KEYBOARD_FIRST_MODIFIER; k <= HID_KEYBOARD_LAST_MODIFIER; ++k) {
-      uint8_t kTmp = k - HID_KEYBOARD_FIRST_MODIFIER;
-      if(!!(report_data_.modifiers & (1 << kTmp))) {
-         activeModifiers.push_back(k);
-      }
-   }
-   return activeModifiers;
+   return this->getActiveModifierSet().toVector();
 }
 
 bool  
@@ -169,17 +170,6 @@ void
    memcpy(&report_data_, &report_data, sizeof(report_data_));
 }
 
-// For each bit set in 'bitfield', output the corresponding string to 'stream'
-#define FOREACHBIT(bitfield, stream, str0, str1, str2, str3, str4, str5, str6, str7) \
-  if((bitfield) & 1<<0) stream << str0; \
-  if((bitfield) & 1<<1) stream << str1; \
-  if((bitfield) & 1<<2) stream << str2; \
-  if((bitfield) & 1<<3) stream << str3; \
-  if((bitfield) & 1<<4) stream << str4; \
-  if((bitfield) & 1<<5) stream << str5; \
-  if((bitfield) & 1<<6) stream << str6; \
-  if((bitfield) & 1<<7) stream << str7;
-  
 void
    KeyboardReport
       ::dump(const papilio::Simulator &simulator, const char *add_indent) const
@@ -193,55 +183,20 @@ void
   if(!anything) {
     out << add_indent << "<none>";
   } else {
-     out << add_indent;
-    FOREACHBIT(report_data_.modifiers, out,
-        "lctrl ", "lshift ", "lalt ", "lgui ",
-        "rctrl ", "rshift ", "ralt ", "rgui ")
-    FOREACHBIT(report_data_.keys[0], out,
-        "NO_EVENT ", "ERROR_ROLLOVER ", "POST_FAIL ", "ERROR_UNDEFINED ",
-        "a ", "b ", "c ", "d ")
-    FOREACHBIT(report_data_.keys[1], out,
-        "e ", "f ", "g ", "h ", "i ", "j ", "k ", "l ")
-    FOREACHBIT(report_data_.keys[2], out,
-        "m ", "n ", "o ", "p ", "q ", "r ", "s ", "t ")
-    FOREACHBIT(report_data_.keys[3], out,
-        "u ", "v ", "w ", "x ", "y ", "z ", "1/! ", "2/@ ")
-    FOREACHBIT(report_data_.keys[4], out,
-        "3/# ", "4/$ ", "5/% ", "6/^ ", "7/& ", "8/* ", "9/( ", "0/) ")
-    FOREACHBIT(report_data_.keys[5], out,
-        "enter ", "esc ", "del/bksp ", "tab ",
-        "space ", "-/_ ", "=/+ ", "[/{ ")
-    FOREACHBIT(report_data_.keys[6], out,
-        "]/} ", "\\/| ", "#/~ ", ";/: ", "'/\" ", "`/~ ", ",/< ", "./> ")
-    FOREACHBIT(report_data_.keys[7], out,
-        "//? ", "capslock ", "F1 ", "F2 ", "F3 ", "F4 ", "F5 ", "F6 ")
-    FOREACHBIT(report_data_.keys[8], out,
-        "F7 ", "F8 ", "F9 ", "F10 ", "F11 ", "F12 ", "prtscr ", "scrolllock ")
-    FOREACHBIT(report_data_.keys[9], out,
-        "pause ", "ins ", "home ", "pgup ", "del ", "end ", "pgdn ", "r_arrow ")
-    FOREACHBIT(report_data_.keys[10], out,
-        "l_arrow ", "d_arrow ", "u_arrow ", "numlock ",
-        "num/ ", "num* ", "num- ", "num+ ")
-    FOREACHBIT(report_data_.keys[11], out,
-        "numenter ", "num1 ", "num2 ", "num3 ",
-        "num4 ", "num5 ", "num6 ", "num7 ")
-    FOREACHBIT(report_data_.keys[12], out,
-        "num8 ", "num9 ", "num0 ", "num. ", "\\/| ", "app ", "power ", "num= ")
-    FOREACHBIT(report_data_.keys[13], out,
-        "F13 ", "F14 ", "F15 ", "F16 ", "F17 ", "F18 ", "F19 ", "F20 ")
-    FOREACHBIT(report_data_.keys[14], out,
-        "F21 ", "F22 ", "F23 ", "F24 ", "exec ", "help ", "menu ", "sel ")
-    FOREACHBIT(report_data_.keys[15], out,
-        "stop ", "again ", "undo ", "cut ", "copy ", "paste ", "find ", "mute ")
-    FOREACHBIT(report_data_.keys[16], out,
-        "volup ", "voldn ", "capslock_l ", "numlock_l ",
-        "scrolllock_l ", "num, ", "num= ", "(other) ")
-    for(int i = 17; i < KEY_BYTES; i++) {
-      // A little imprecise, in two ways:
-      //   (1) obviously, "(other)" refers to many distinct keys
-      //   (2) this might undercount the number of "other" keys pressed
-      // Therefore, if any keys are frequently used, they should be handled above and not via "other"
-      if(report_data_.keys[i]) out << "(other) ";
+    out << add_indent;
+    for(uint8_t m = 0; m < 8; m++) {
+      if(report_data_.modifiers & (1 << m)) {
+        out << getHIDUsage(HID_KEYBOARD_FIRST_MODIFIER + m).dump_name << ' ';
+      }
+    }
+    for(int i = 0; i < KEY_BYTES; i++) {
+      if(!report_data_.keys[i]) continue;
+      for(int j = 0; j < 8; j++) {
+        if(report_data_.keys[i] & (1 << j)) {
+          const char *dump_name = getHIDUsage(i*8 + j).dump_name;
+          out << ((dump_name) ? dump_name : "(other)") << ' ';
+        }
+      }
     }
   }
 }
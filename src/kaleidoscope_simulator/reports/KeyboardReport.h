@@ -22,6 +22,8 @@
 
 #include "kaleidoscope/key_defs.h"
 #include "papilio/reports/KeyboardReport_.h"
+#include "kaleidoscope_simulator/reports/ReportPool.h"
+#include "kaleidoscope_simulator/reports/KeycodeSet.h"
 #include "MultiReport/Keyboard.h"
 
 // Undefine some macros defined by Arduino
@@ -40,7 +42,7 @@ class Simulator;
   
 /// @brief An interface hat facilitates analyzing keyboard reports.
 ///
-class KeyboardReport : public papilio::KeyboardReport_ {
+class KeyboardReport final : public papilio::KeyboardReport_ {
    
    public:
       
@@ -66,9 +68,7 @@ class KeyboardReport : public papilio::KeyboardReport_ {
       
       template<typename..._Args>
       static std::shared_ptr<KeyboardReport> create(_Args &&... args) {
-         return std::shared_ptr<KeyboardReport>{
-            new KeyboardReport{std::forward<_Args>(args)...}
-         };
+         return makePooledReport<KeyboardReport>(std::forward<_Args>(args)...);
       }
       
       virtual std::shared_ptr<papilio::Report_> clone() const override;
@@ -112,6 +112,21 @@ class KeyboardReport : public papilio::KeyboardReport_ {
       ///
       virtual std::vector<uint8_t> getActiveModifiers() const override;
       
+      /// @brief Retreives the set of all keycodes that are active in the
+      ///        keyboard report.
+      /// @details Unlike getActiveKeycodes(), this does not allocate.
+      ///
+      KeycodeSet getActiveKeycodeSet() const;
+      
+      /// @brief Retreives the set of active modifier keycodes.
+      /// @details Unlike getActiveModifiers(), this does not allocate.
+      ///
+      KeycodeSet getActiveModifierSet() const;
+      
+      /// @brief Retreives the number of active key keycodes.
+      ///
+      size_t getNumActiveKeycodes() const;
+      
       /// @brief Checks if the report is empty.
       /// @details Empty means neither key nor modifier keycodes are active.
       ///
@@ -0,0 +1,215 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <iterator>
+#include <vector>
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief A set of HID keycodes.
+/// @details The set is a bitmap of all 256 keycodes, stored in
+///        64 bit words. It never allocates. Queries work on whole
+///        words, counting uses popcount and iteration skips
+///        from one member to the next by counting trailing zeros.
+///
+class KeycodeSet
+{
+   public:
+
+      static constexpr int n_words = 4;
+
+      /// @brief Iterates the keycodes of a set in ascending order.
+      ///
+      class Iterator
+      {
+         public:
+
+            typedef std::forward_iterator_tag iterator_category;
+            typedef uint8_t value_type;
+            typedef ptrdiff_t difference_type;
+            typedef const uint8_t *pointer;
+            typedef uint8_t reference;
+
+            Iterator(const uint64_t *words, int word_id)
+               :  words_(words),
+                  word_id_(word_id),
+                  bits_((word_id < n_words) ? words[word_id] : 0)
+            {
+               this->skipEmptyWords();
+            }
+
+            uint8_t operator*() const {
+               return uint8_t(64*word_id_ + __builtin_ctzll(bits_));
+            }
+
+            Iterator &operator++() {
+               bits_ &= bits_ - 1;
+               this->skipEmptyWords();
+               return *this;
+            }
+
+            Iterator operator++(int) {
+               Iterator tmp = *this;
+               ++*this;
+               return tmp;
+            }
+
+            bool operator==(const Iterator &other) const {
+               return (word_id_ == other.word_id_) && (bits_ == other.bits_);
+            }
+            bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+         private:
+
+            void skipEmptyWords() {
+               while((bits_ == 0) && (word_id_ < n_words)) {
+                  ++word_id_;
+                  bits_ = (word_id_ < n_words) ? words_[word_id_] : 0;
+               }
+            }
+
+            const uint64_t *words_;
+            int word_id_;
+            uint64_t bits_;
+      };
+
+      KeycodeSet() : words_{} {}
+
+      /// @brief Creates a set from a keycode bitmap.
+      /// @details Bit i of byte j of the bitmap represents
+      ///        keycode first_keycode + 8*j + i.
+      /// @param bitmap The bitmap.
+      /// @param n_bytes The size of the bitmap in bytes.
+      /// @param first_keycode The keycode of the first bit.
+      ///        Must be a multiple of eight.
+      ///
+      static KeycodeSet fromBitmap(const uint8_t *bitmap, size_t n_bytes,
+                                   uint8_t first_keycode = 0) {
+         KeycodeSet set;
+         set.orBitmap(bitmap, n_bytes, first_keycode);
+         return set;
+      }
+
+      bool contains(uint8_t keycode) const {
+         return (words_[keycode/64] >> (keycode % 64)) & 1;
+      }
+
+      void insert(uint8_t keycode) {
+         words_[keycode/64] |= uint64_t(1) << (keycode % 64);
+      }
+
+      void erase(uint8_t keycode) {
+         words_[keycode/64] &= ~(uint64_t(1) << (keycode % 64));
+      }
+
+      /// @brief Removes all keycodes that are greater than a given one.
+      ///
+      void truncate(uint8_t last_keycode) {
+         int word_id = last_keycode/64;
+         int bit = last_keycode % 64;
+         if(bit != 63) {
+            words_[word_id] &= (uint64_t(1) << (bit + 1)) - 1;
+         }
+         for(int i = word_id + 1; i < n_words; ++i) {
+            words_[i] = 0;
+         }
+      }
+
+      bool empty() const {
+         uint64_t any = 0;
+         for(int i = 0; i < n_words; ++i) { any |= words_[i]; }
+         return any == 0;
+      }
+
+      size_t size() const {
+         size_t n = 0;
+         for(int i = 0; i < n_words; ++i) { n += __builtin_popcountll(words_[i]); }
+         return n;
+      }
+
+      Iterator begin() const { return Iterator{words_, 0}; }
+      Iterator end() const { return Iterator{words_, n_words}; }
+
+      /// @brief Copies the keycodes to a vector in ascending order.
+      ///
+      std::vector<uint8_t> toVector() const {
+         std::vector<uint8_t> keycodes;
+         keycodes.reserve(this->size());
+         for(auto keycode: *this) { keycodes.push_back(keycode); }
+         return keycodes;
+      }
+
+      KeycodeSet operator|(const KeycodeSet &other) const {
+         KeycodeSet result;
+         for(int i = 0; i < n_words; ++i) { result.words_[i] = words_[i] | other.words_[i]; }
+         return result;
+      }
+
+      KeycodeSet operator&(const KeycodeSet &other) const {
+         KeycodeSet result;
+         for(int i = 0; i < n_words; ++i) { result.words_[i] = words_[i] & other.words_[i]; }
+         return result;
+      }
+
+      KeycodeSet operator^(const KeycodeSet &other) const {
+         KeycodeSet result;
+         for(int i = 0; i < n_words; ++i) { result.words_[i] = words_[i] ^ other.words_[i]; }
+         return result;
+      }
+
+      /// @brief The keycodes of this set that are not in another one.
+      ///
+      KeycodeSet operator-(const KeycodeSet &other) const {
+         KeycodeSet result;
+         for(int i = 0; i < n_words; ++i) { result.words_[i] = words_[i] & ~other.words_[i]; }
+         return result;
+      }
+
+      bool operator==(const KeycodeSet &other) const {
+         return memcmp(words_, other.words_, sizeof(words_)) == 0;
+      }
+      bool operator!=(const KeycodeSet &other) const { return !(*this == other); }
+
+   private:
+
+      void orBitmap(const uint8_t *bitmap, size_t n_bytes, uint8_t first_keycode) {
+         uint8_t *bytes = reinterpret_cast<uint8_t*>(words_) + first_keycode/8;
+         size_t max_bytes = sizeof(words_) - first_keycode/8;
+         if(n_bytes > max_bytes) { n_bytes = max_bytes; }
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+         for(size_t i = 0; i < n_bytes; ++i) { bytes[i] |= bitmap[i]; }
+#else
+         (void)bytes;
+         for(size_t i = 0; i < n_bytes; ++i) {
+            size_t byte_id = first_keycode/8 + i;
+            words_[byte_id/8] |= uint64_t(bitmap[i]) << (8*(byte_id % 8));
+         }
+#endif
+      }
+
+      uint64_t words_[n_words];
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
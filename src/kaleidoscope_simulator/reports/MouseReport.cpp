@@ -18,6 +18,8 @@
 
 #include "kaleidoscope_simulator/reports/MouseReport.h"
 #include "papilio/Simulator.h"
+
+#include <typeinfo>
  
 namespace kaleidoscope {
 namespace simulator {
@@ -42,15 +44,14 @@ namespace simulator {
 
 std::shared_ptr<papilio::Report_> MouseReport::clone() const
 {
-   return std::shared_ptr<papilio::Report_>{ new MouseReport{*this} };
+   return makePooledReport<MouseReport>(*this);
 }
 
 bool MouseReport::equals(const papilio::Report_ &other) const
 {
-   const MouseReport *other_mr =
-      dynamic_cast<const MouseReport *>(&other);
-      
-   if(!other_mr) { return false; }
+   if(typeid(other) != typeid(MouseReport)) { return false; }
+   
+   const MouseReport *other_mr = static_cast<const MouseReport *>(&other);
    
    return memcmp(&report_data_, &other_mr->report_data_, sizeof(report_data_)) == 0;
 }
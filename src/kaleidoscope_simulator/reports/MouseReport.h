@@ -20,6 +20,7 @@
 
 #include "MultiReport/Mouse.h"
 #include "papilio/reports/MouseReport_.h"
+#include "kaleidoscope_simulator/reports/ReportPool.h"
 
 // Undefine some macros defined by Arduino
 //
@@ -37,7 +38,7 @@ class Simulator;
   
 /// @brief An interface hat facilitates analyzing mouse reports.
 ///
-class MouseReport : public papilio::MouseReport_ {
+class MouseReport final : public papilio::MouseReport_ {
    
    public:
       
@@ -63,9 +64,7 @@ class MouseReport : public papilio::MouseReport_ {
       
       template<typename..._Args>
       static std::shared_ptr<MouseReport> create(_Args &&... args) {
-         return std::shared_ptr<MouseReport>{
-            new MouseReport{std::forward<_Args>(args)...}
-         };
+         return makePooledReport<MouseReport>(std::forward<_Args>(args)...);
       }
       
       virtual std::shared_ptr<papilio::Report_> clone() const override;
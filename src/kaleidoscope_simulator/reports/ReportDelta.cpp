@@ -0,0 +1,192 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Important: Leave stdint.h the first header as some other Kaleidoscope
+//            related stuff depends on standard integer types to be defined
+//            (Arduino defines them auto-magically).
+//
+#include <stdint.h>
+
+#include "kaleidoscope_simulator/reports/ReportDelta.h"
+#include "kaleidoscope_simulator/HIDUsageTable.h"
+#include "kaleidoscope_simulator/aux/exceptions.h"
+#include "papilio/Simulator.h"
+
+namespace kaleidoscope {
+namespace simulator {
+
+namespace {
+
+template<typename _Stream>
+void streamKeycodes(_Stream &out, const char *label, const KeycodeSet &keycodes)
+{
+   if(keycodes.empty()) { return; }
+
+   out << ' ' << label << ':';
+   for(auto keycode: keycodes) {
+      const char *dump_name = getHIDUsage(keycode).dump_name;
+      out << ' ' << ((dump_name) ? dump_name : "(other)");
+   }
+}
+
+} // namespace
+
+   ReportDelta
+      ::ReportDelta(const HIDReport &previous, const HIDReport &current)
+   :  type_(current.getType())
+{
+   if(type_ == HIDReportType::none) { return; }
+
+   if(previous.getType() == HIDReportType::none) {
+
+      // An empty report of the current report's type.
+      //
+      static const uint8_t empty_data[64] = {};
+      static_assert(sizeof(KeyboardReport::ReportDataType) <= sizeof(empty_data),
+                    "Empty report data too small");
+
+      *this = ReportDelta{HIDReport{current.getId(), empty_data}, current};
+      return;
+   }
+
+   if(previous.getType() != type_) {
+      KS_T_EXCEPTION("Unable to compute the delta of HID reports of different types")
+   }
+
+   switch(type_) {
+      case HIDReportType::boot_keyboard:
+         this->setKeyboardDelta(previous.get<BootKeyboardReport>(),
+                                current.get<BootKeyboardReport>());
+         break;
+      case HIDReportType::keyboard:
+         this->setKeyboardDelta(previous.get<KeyboardReport>(),
+                                current.get<KeyboardReport>());
+         break;
+      case HIDReportType::mouse:
+         {
+            const auto &report_data = current.get<MouseReport>().getReportData();
+
+            this->setButtonDelta(previous.get<MouseReport>().getReportData().buttons,
+                                 report_data.buttons);
+
+            x_movement_ = report_data.xAxis;
+            y_movement_ = report_data.yAxis;
+            vertical_wheel_ = report_data.vWheel;
+            horizontal_wheel_ = report_data.hWheel;
+         }
+         break;
+      case HIDReportType::absolute_mouse:
+         {
+            const auto &previous_data = previous.get<AbsoluteMouseReport>().getReportData();
+            const auto &report_data = current.get<AbsoluteMouseReport>().getReportData();
+
+            this->setButtonDelta(previous_data.buttons, report_data.buttons);
+
+            x_movement_ = int(report_data.xAxis) - int(previous_data.xAxis);
+            y_movement_ = int(report_data.yAxis) - int(previous_data.yAxis);
+            vertical_wheel_ = report_data.wheel;
+         }
+         break;
+      case HIDReportType::none:
+         break;
+   }
+}
+
+void ReportDelta::dump(const papilio::Simulator &simulator, const char *add_indent) const
+{
+   auto out = simulator.log();
+   out << add_indent << "Report delta:";
+   this->stream(out);
+}
+
+void ReportDelta::print(std::ostream &out) const
+{
+   this->stream(out);
+}
+
+template<typename _ReportType>
+void ReportDelta::setKeyboardDelta(const _ReportType &previous, const _ReportType &current)
+{
+   auto previous_keycodes = previous.getActiveKeycodeSet();
+   auto current_keycodes = current.getActiveKeycodeSet();
+   auto changed_keycodes = previous_keycodes ^ current_keycodes;
+
+   pressed_keycodes_ = changed_keycodes & current_keycodes;
+   released_keycodes_ = changed_keycodes & previous_keycodes;
+
+   auto previous_modifiers = previous.getActiveModifierSet();
+   auto current_modifiers = current.getActiveModifierSet();
+   auto changed_modifiers = previous_modifiers ^ current_modifiers;
+
+   pressed_modifiers_ = changed_modifiers & current_modifiers;
+   released_modifiers_ = changed_modifiers & previous_modifiers;
+}
+
+void ReportDelta::setButtonDelta(uint8_t previous, uint8_t current)
+{
+   uint8_t changed = previous ^ current;
+
+   pressed_buttons_ = changed & current;
+   released_buttons_ = changed & previous;
+}
+
+bool ReportDelta::isEmpty() const
+{
+   return pressed_keycodes_.empty()
+       && released_keycodes_.empty()
+       && pressed_modifiers_.empty()
+       && released_modifiers_.empty()
+       && (pressed_buttons_ == 0)
+       && (released_buttons_ == 0)
+       && (x_movement_ == 0)
+       && (y_movement_ == 0)
+       && (vertical_wheel_ == 0)
+       && (horizontal_wheel_ == 0);
+}
+
+template<typename _Stream>
+void ReportDelta::stream(_Stream &out) const
+{
+   if(this->isEmpty()) {
+      out << " <none>";
+      return;
+   }
+
+   switch(type_) {
+      case HIDReportType::boot_keyboard:
+      case HIDReportType::keyboard:
+         streamKeycodes(out, "pressed", pressed_keycodes_);
+         streamKeycodes(out, "released", released_keycodes_);
+         streamKeycodes(out, "modifiers pressed", pressed_modifiers_);
+         streamKeycodes(out, "modifiers released", released_modifiers_);
+         break;
+      case HIDReportType::mouse:
+      case HIDReportType::absolute_mouse:
+         out << " buttons pressed: " << (int)pressed_buttons_
+             << ", buttons released: " << (int)released_buttons_
+             << ", x/y-axis motion: " << x_movement_ << '/' << y_movement_
+             << ", vertical/horizontal wheel motion: " << vertical_wheel_ 
+             << '/' << horizontal_wheel_;
+         break;
+      case HIDReportType::none:
+         break;
+   }
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
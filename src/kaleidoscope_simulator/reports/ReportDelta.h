@@ -0,0 +1,137 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "kaleidoscope_simulator/reports/HIDReport.h"
+#include "kaleidoscope_simulator/reports/KeycodeSet.h"
+
+#include <stdint.h>
+#include <ostream>
+
+namespace papilio {
+class Simulator;
+} // namespace papilio
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief The difference between two consecutive reports of the same type.
+/// @details For keyboard reports, the delta holds the keycodes and
+///        modifiers that were pressed or released. They are
+///        determined by XOR-ing the keycode bitmaps of both reports.
+///
+///        For mouse reports, the delta holds the buttons that were
+///        pressed or released and the movement. The movement of
+///        relative mouse reports is that of the current report. For
+///        absolute mouse reports, it is the difference of the positions.
+///
+class ReportDelta
+{
+   public:
+
+      /// @brief Default constructor.
+      /// @details Creates an empty delta of type none.
+      ///
+      ReportDelta() {}
+
+      /// @brief Constructs the delta between two reports.
+      /// @details A previous report of type none is treated as an empty
+      ///        report of the current report's type. Throws if both
+      ///        reports are of different types.
+      /// @param previous The previous report.
+      /// @param current The current report.
+      ///
+      ReportDelta(const HIDReport &previous, const HIDReport &current);
+
+      HIDReportType getType() const { return type_; }
+
+      /// @brief The key keycodes that became active.
+      ///
+      const KeycodeSet &getPressedKeycodes() const { return pressed_keycodes_; }
+
+      /// @brief The key keycodes that became inactive.
+      ///
+      const KeycodeSet &getReleasedKeycodes() const { return released_keycodes_; }
+
+      /// @brief The modifier keycodes that became active.
+      ///
+      const KeycodeSet &getPressedModifiers() const { return pressed_modifiers_; }
+
+      /// @brief The modifier keycodes that became inactive.
+      ///
+      const KeycodeSet &getReleasedModifiers() const { return released_modifiers_; }
+
+      /// @brief A bitfield of the mouse buttons that became pressed.
+      ///
+      uint8_t getPressedButtons() const { return pressed_buttons_; }
+
+      /// @brief A bitfield of the mouse buttons that became released.
+      ///
+      uint8_t getReleasedButtons() const { return released_buttons_; }
+
+      int getXMovement() const { return x_movement_; }
+      int getYMovement() const { return y_movement_; }
+      int getVerticalWheel() const { return vertical_wheel_; }
+      int getHorizontalWheel() const { return horizontal_wheel_; }
+
+      /// @brief Checks if nothing changed.
+      ///
+      bool isEmpty() const;
+
+      /// @brief Writes a formatted representation of the delta
+      ///        to the simulator's log stream.
+      /// @param add_indent An additional indentation string.
+      ///
+      void dump(const papilio::Simulator &simulator, const char *add_indent = "") const;
+
+      /// @brief Writes a formatted representation of the delta
+      ///        to a stream.
+      /// @details The same as dump(...) writes, without the heading.
+      /// @param out The stream to write to.
+      ///
+      void print(std::ostream &out) const;
+
+   private:
+
+      template<typename _Stream>
+      void stream(_Stream &out) const;
+
+      template<typename _ReportType>
+      void setKeyboardDelta(const _ReportType &previous, const _ReportType &current);
+
+      void setButtonDelta(uint8_t previous, uint8_t current);
+
+      HIDReportType type_ = HIDReportType::none;
+
+      KeycodeSet pressed_keycodes_;
+      KeycodeSet released_keycodes_;
+      KeycodeSet pressed_modifiers_;
+      KeycodeSet released_modifiers_;
+
+      uint8_t pressed_buttons_ = 0;
+      uint8_t released_buttons_ = 0;
+
+      int x_movement_ = 0;
+      int y_movement_ = 0;
+      int vertical_wheel_ = 0;
+      int horizontal_wheel_ = 0;
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
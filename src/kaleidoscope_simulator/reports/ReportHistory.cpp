@@ -0,0 +1,80 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Important: Leave stdint.h the first header as some other Kaleidoscope
+//            related stuff depends on standard integer types to be defined
+//            (Arduino defines them auto-magically).
+//
+#include <stdint.h>
+
+#include "kaleidoscope_simulator/reports/ReportHistory.h"
+
+namespace kaleidoscope {
+namespace simulator {
+
+   ReportHistory
+      ::ReportHistory(size_t capacity)
+{
+   this->setCapacity(capacity);
+}
+
+void ReportHistory::setCapacity(size_t capacity)
+{
+   capacity_ = capacity;
+
+   for(auto &ring: rings_) {
+      ring.reset(capacity);
+   }
+}
+
+void ReportHistory::add(const HIDReport &report, uint32_t cycle_id, uint32_t time)
+{
+   if(report.getType() == HIDReportType::none) { return; }
+
+   rings_[int(report.getType())].add(report, cycle_id, time);
+}
+
+void ReportHistory::clear()
+{
+   for(auto &ring: rings_) {
+      ring.clear();
+   }
+}
+
+ReportHistory::Range ReportHistory::getLast(HIDReportType type, size_t n) const
+{
+   const auto &ring = rings_[int(type)];
+   return Range{&ring, (n < ring.size()) ? n : ring.size()};
+}
+
+ReportHistory::Range ReportHistory::getSince(HIDReportType type, uint32_t start_time) const
+{
+   const auto &ring = rings_[int(type)];
+
+   // Reports are stored in the order of their emission.
+   //
+   size_t n = 0;
+   while((n < ring.size()) && (ring.get(n).time >= start_time)) {
+      ++n;
+   }
+
+   return Range{&ring, n};
+}
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,242 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "kaleidoscope_simulator/reports/HIDReport.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <iterator>
+#include <vector>
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief A bounded history of the reports emitted by the firmware.
+/// @details The reports of every report type are stored in a ring
+///        buffer of fixed capacity. Once a buffer is full, every new
+///        report replaces the oldest one of its type. Storage is
+///        allocated when the capacity is set, adding reports
+///        never allocates.
+///
+///        Queries return the reports of a type from the newest
+///        to the oldest.
+///
+class ReportHistory
+{
+   public:
+
+      /// @brief A stored report.
+      ///
+      struct Entry
+      {
+         HIDReport report;
+
+         /// @brief The cycle the report was emitted in
+         ///        (see SimulatorCore::getCycleCount()).
+         ///
+         uint32_t cycle_id = 0;
+
+         /// @brief The simulated time [ms] when the report was emitted.
+         ///
+         uint32_t time = 0;
+      };
+
+   private:
+
+      class Ring
+      {
+         public:
+
+            void reset(size_t capacity) {
+               entries_.clear();
+               entries_.resize(capacity);
+               next_ = 0;
+               size_ = 0;
+            }
+
+            void add(const HIDReport &report, uint32_t cycle_id, uint32_t time) {
+               if(entries_.empty()) { return; }
+               auto &entry = entries_[next_];
+               entry.report = report;
+               entry.cycle_id = cycle_id;
+               entry.time = time;
+               next_ = (next_ + 1) % entries_.size();
+               if(size_ < entries_.size()) { ++size_; }
+            }
+
+            void clear() { next_ = 0; size_ = 0; }
+
+            size_t size() const { return size_; }
+
+            // Entry 0 is the newest.
+            //
+            const Entry &get(size_t i) const {
+               return entries_[(next_ + entries_.size() - 1 - i) % entries_.size()];
+            }
+
+         private:
+
+            std::vector<Entry> entries_;
+            size_t next_ = 0;
+            size_t size_ = 0;
+      };
+
+   public:
+
+      /// @brief A view of the newest reports of a type.
+      /// @details The view is invalidated when reports are added.
+      ///
+      class Range
+      {
+         public:
+
+            class Iterator
+            {
+               public:
+
+                  typedef std::forward_iterator_tag iterator_category;
+                  typedef Entry value_type;
+                  typedef ptrdiff_t difference_type;
+                  typedef const Entry *pointer;
+                  typedef const Entry &reference;
+
+                  Iterator(const Ring *ring, size_t i) : ring_(ring), i_(i) {}
+
+                  const Entry &operator*() const { return ring_->get(i_); }
+                  const Entry *operator->() const { return &ring_->get(i_); }
+
+                  Iterator &operator++() { ++i_; return *this; }
+                  Iterator operator++(int) { Iterator tmp = *this; ++i_; return tmp; }
+
+                  bool operator==(const Iterator &other) const { return i_ == other.i_; }
+                  bool operator!=(const Iterator &other) const { return i_ != other.i_; }
+
+               private:
+
+                  const Ring *ring_;
+                  size_t i_;
+            };
+
+            Range(const Ring *ring, size_t size) : ring_(ring), size_(size) {}
+
+            Iterator begin() const { return Iterator{ring_, 0}; }
+            Iterator end() const { return Iterator{ring_, size_}; }
+
+            size_t size() const { return size_; }
+            bool empty() const { return size_ == 0; }
+
+            /// @brief Access an entry.
+            /// @param i The index of the entry, zero is the newest.
+            ///
+            const Entry &operator[](size_t i) const { return ring_->get(i); }
+
+         private:
+
+            const Ring *ring_;
+            size_t size_;
+      };
+
+      /// @brief Constructor.
+      /// @param capacity The max. number of reports stored per report type.
+      ///
+      explicit ReportHistory(size_t capacity = 64);
+
+      /// @brief Changes the max. number of reports stored per report type.
+      /// @details All stored reports are removed.
+      ///
+      void setCapacity(size_t capacity);
+
+      size_t getCapacity() const { return capacity_; }
+
+      /// @brief Stores a report.
+      /// @details Reports of type none are ignored.
+      /// @param report The report.
+      /// @param cycle_id The cycle the report was emitted in.
+      /// @param time The simulated time [ms] when the report was emitted.
+      ///
+      void add(const HIDReport &report, uint32_t cycle_id, uint32_t time);
+
+      /// @brief Removes all stored reports.
+      ///
+      void clear();
+
+      /// @brief Retreives the number of stored reports of a type.
+      ///
+      size_t getSize(HIDReportType type) const { return rings_[int(type)].size(); }
+
+      /// @brief Retreives the newest reports of a type.
+      /// @param type The report type.
+      /// @param n The max. number of reports.
+      /// @returns A view of at most n reports.
+      ///
+      Range getLast(HIDReportType type, size_t n) const;
+
+      /// @brief Retreives all stored reports of a type.
+      ///
+      Range getAll(HIDReportType type) const {
+         return this->getLast(type, this->getSize(type));
+      }
+
+      /// @brief Retreives the reports of a type that were emitted
+      ///        at or after a given time.
+      /// @details Relies on the reports being stored in the order 
+      ///        of their time stamps. Simulator::restoreSnapshot(...)
+      ///        therefore clears the history.
+      /// @param type The report type.
+      /// @param start_time The start time [ms] of the time window.
+      ///
+      Range getSince(HIDReportType type, uint32_t start_time) const;
+
+      /// @brief Finds the newest report of a type that matches a predicate.
+      /// @param type The report type.
+      /// @param predicate A function that is passed an Entry and returns
+      ///        true if it matches.
+      /// @returns The entry or nullptr if no stored report matches.
+      ///
+      template<typename _Predicate>
+      const Entry *findLast(HIDReportType type, _Predicate &&predicate) const {
+         for(const auto &entry: this->getAll(type)) {
+            if(predicate(entry)) { return &entry; }
+         }
+         return nullptr;
+      }
+
+      /// @brief Counts the stored reports of a type that match a predicate.
+      /// @param type The report type.
+      /// @param predicate A function that is passed an Entry and returns
+      ///        true if it matches.
+      ///
+      template<typename _Predicate>
+      size_t count(HIDReportType type, _Predicate &&predicate) const {
+         size_t n = 0;
+         for(const auto &entry: this->getAll(type)) {
+            if(predicate(entry)) { ++n; }
+         }
+         return n;
+      }
+
+   private:
+
+      size_t capacity_ = 0;
+      Ring rings_[int(HIDReportType::absolute_mouse) + 1];
+};
+
+} // namespace simulator
+} // namespace kaleidoscope
@@ -0,0 +1,144 @@
+/* -*- mode: c++ -*-
+ * Kaleidoscope-Simulator -- A C++ testing API for the Kaleidoscope keyboard
+ *                         firmware.
+ * Copyright (C) 2019  noseglasses (shinynoseglasses@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace kaleidoscope {
+namespace simulator {
+
+/// @brief A free list of memory blocks of a fixed size.
+/// @details Blocks are allocated from the heap the first time they
+///        are needed and are never returned to it. Once a replay
+///        has reached its max. number of live report objects,
+///        no further heap allocations happen.
+///
+///        There is one pool per type and thread. The pool
+///        deliberately lives in thread local storage and not in
+///        the .data or .bss section, as the latter are overwritten
+///        when a FirmwareSnapshot is restored. It has no destructor
+///        as reports that are owned by static objects may be
+///        released after thread local objects have been destroyed.
+///
+template<typename _T>
+class ReportPool
+{
+   public:
+
+      /// @brief Access the calling thread's pool.
+      ///
+      static ReportPool &get() {
+         static thread_local ReportPool pool;
+         return pool;
+      }
+
+      /// @brief Retreives a block that is large enough for one object
+      ///        of type _T.
+      ///
+      void *allocate() {
+         if(!free_list_) {
+            return ::operator new(sizeof(Block));
+         }
+         Block *block = free_list_;
+         free_list_ = block->next;
+         --n_free_;
+         return block;
+      }
+
+      /// @brief Returns a block to the pool.
+      /// @param p The address of a block that was retreived
+      ///        by allocate().
+      ///
+      void deallocate(void *p) {
+         Block *block = static_cast<Block*>(p);
+         block->next = free_list_;
+         free_list_ = block;
+         ++n_free_;
+      }
+
+      /// @brief The number of blocks that are available without
+      ///        allocating from the heap.
+      ///
+      size_t getNumFree() const { return n_free_; }
+
+   private:
+
+      union Block {
+         Block *next;
+         typename std::aligned_storage<sizeof(_T), alignof(_T)>::type storage;
+      };
+
+      Block *free_list_ = nullptr;
+      size_t n_free_ = 0;
+};
+
+/// @brief An allocator that draws single objects from a ReportPool.
+/// @details Requests for arrays are passed on to the heap.
+///
+template<typename _T>
+struct ReportPoolAllocator
+{
+   typedef _T value_type;
+
+   ReportPoolAllocator() = default;
+
+   template<typename _U>
+   ReportPoolAllocator(const ReportPoolAllocator<_U> &) {}
+
+   _T *allocate(size_t n) {
+      if(n != 1) {
+         return static_cast<_T*>(::operator new(n*sizeof(_T)));
+      }
+      return static_cast<_T*>(ReportPool<_T>::get().allocate());
+   }
+
+   void deallocate(_T *p, size_t n) {
+      if(n != 1) {
+         ::operator delete(p);
+         return;
+      }
+      ReportPool<_T>::get().deallocate(p);
+   }
+
+   template<typename _U>
+   bool operator==(const ReportPoolAllocator<_U> &) const { return true; }
+   template<typename _U>
+   bool operator!=(const ReportPoolAllocator<_U> &) const { return false; }
+};
+
+/// @brief Creates a report object whose storage, including that of
+///        the shared pointer's control block, is drawn from a pool.
+/// @details Releasing the last shared pointer to the report
+///        returns the storage to the pool.
+/// @tparam _ReportType The report type.
+/// @param args The arguments passed to the report's constructor.
+///
+template<typename _ReportType, typename..._Args>
+std::shared_ptr<_ReportType> makePooledReport(_Args &&... args)
+{
+   return std::allocate_shared<_ReportType>(ReportPoolAllocator<_ReportType>{},
+                                             std::forward<_Args>(args)...);
+}
+
+} // namespace simulator
+} // namespace kaleidoscope